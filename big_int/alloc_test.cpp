@@ -0,0 +1,132 @@
+// Counts heap allocations made by big_integer: values of up to storage::INLINE_CAPACITY words
+// must not touch the heap, and larger expressions must reuse their temporaries. Also checks that
+// nothing cached inside the library outlives an arena installed with memory_scope.
+// g++ -std=c++17 -O2 -pthread alloc_test.cpp big_integer.cpp limbs.cpp storage.cpp allocation.cpp parallel.cpp -o alloc_test
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <utility>
+
+#include "allocation.h"
+#include "big_integer.h"
+
+namespace {
+    size_t allocations = 0;
+    int failures = 0;
+
+    void check(bool ok, char const* what, size_t count) {
+        std::printf("%-40s %zu allocations %s\n", what, count, ok ? "ok" : "FAILED");
+        if (!ok) {
+            ++failures;
+        }
+    }
+
+    // runs f and returns how many times operator new was called meanwhile
+    template <typename F>
+    size_t count(F const& f) {
+        size_t before = allocations;
+        f();
+        return allocations - before;
+    }
+
+    unsigned char arena_buffer[size_t(1) << 24U];
+
+    // 2^(32 * words - 1) + 12345, words limbs long
+    big_integer wide(int words) {
+        return (big_integer(1) << (32 * words - 1)) + 12345;
+    }
+}
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+int main() {
+    big_integer a(123456789);
+    big_integer b(-987654321);
+    big_integer c = wide(3);
+    big_integer r;
+
+    size_t n = count([&] {
+        big_integer x(42);
+        big_integer y(x);
+        big_integer z(std::move(y));
+        r = z;
+        r = std::move(x);
+        r = c;
+    });
+    check(n == 0, "construct, copy, move", n);
+
+    n = count([&] {
+        r = a + b;
+        r += c;
+        r -= a;
+        r = a * b;
+        r *= 3;
+        r = c / a;
+        r %= b;
+        r = -a;
+        r = ~b;
+        ++r;
+        r--;
+        r = (a << 40) >> 13;
+        r = a & b;
+        r |= c;
+        r ^= a;
+        bool less = a < b || a == c;
+        (void) less;
+    });
+    check(n == 0, "small arithmetic", n);
+
+    n = count([&] { r = a * b + c * 7 - a; });
+    check(n == 0, "small chained expression", n);
+
+    // each product copies its left operand and x * y needs a wider buffer for its result;
+    // the sum and the difference are done in that buffer
+    big_integer x = wide(40);
+    big_integer y = wide(40);
+    big_integer z = wide(80);
+    big_integer big = x * y;
+    n = count([&] { big = x * y + z * 5 - x; });
+    check(n <= 3, "wide chained expression", n);
+
+    n = count([&] { big += z; big -= x; });
+    check(n == 0, "wide in-place += and -=", n);
+
+    n = count([&] { big_integer moved(std::move(big)); big = std::move(moved); });
+    check(n == 0, "wide move", n);
+
+    // the first decimal conversions fill the cache of powers of ten; done inside an arena that is
+    // then released and overwritten, they must leave nothing in it that the next ones read
+    big_integer huge = wide(2000) * 987654321;
+    std::string decimal;
+    {
+        std::pmr::monotonic_buffer_resource arena(arena_buffer, sizeof(arena_buffer), std::pmr::null_memory_resource());
+        memory_scope scope(&arena);
+        decimal = to_string(huge);
+        big_integer parsed(decimal);
+        (void) parsed;
+    }
+    std::memset(arena_buffer, 0xa5, sizeof(arena_buffer));
+    bool same = true;
+    n = count([&] { same = to_string(huge) == decimal && big_integer(decimal) == huge; });
+    check(same, "conversions after an arena is released", n);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+#include "allocation.h"
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+namespace {
+    // Size of the first scratch chunk; later ones double. Idle chunks above the limit are returned.
+    size_t const SCRATCH_CHUNK = size_t(1) << 16U;
+    size_t const SCRATCH_RETAIN_LIMIT = size_t(1) << 24U;
+    size_t const SCRATCH_ALIGN = alignof(std::max_align_t);
+
+    thread_local std::pmr::memory_resource* current = nullptr;
+
+    struct scratch_stack {
+        struct chunk {
+            char* data;
+            size_t size;
+        };
+
+        ~scratch_stack() {
+            for (chunk& c : chunks) {
+                operator delete(c.data);
+            }
+        }
+
+        void* allocate(size_t bytes) {
+            bytes = round_up(bytes);
+            if (chunks.empty() || chunks.back().size - top < bytes) {
+                size_t size = std::max(bytes, chunks.empty() ? SCRATCH_CHUNK : 2 * chunks.back().size);
+                chunks.push_back({static_cast<char*>(operator new(size)), size});
+                top = 0;
+            }
+            void* p = chunks.back().data + top;
+            top += bytes;
+            ++live;
+            return p;
+        }
+
+        void deallocate(void* p, size_t bytes) {
+            bytes = round_up(bytes);
+            if (--live == 0) {
+                // keep only the newest chunk, which is the largest
+                for (size_t i = 0; i + 1 < chunks.size(); ++i) {
+                    operator delete(chunks[i].data);
+                }
+                chunks.erase(chunks.begin(), chunks.end() - 1);
+                if (chunks.back().size > SCRATCH_RETAIN_LIMIT) {
+                    operator delete(chunks.back().data);
+                    chunks.clear();
+                }
+                top = 0;
+            } else if (static_cast<char*>(p) + bytes == chunks.back().data + top) {
+                top -= bytes;
+            }
+        }
+
+        static size_t round_up(size_t bytes) {
+            return (bytes + SCRATCH_ALIGN - 1) / SCRATCH_ALIGN * SCRATCH_ALIGN;
+        }
+
+        std::vector<chunk> chunks;
+        // bytes used in the newest chunk
+        size_t top = 0;
+        size_t live = 0;
+    };
+
+    thread_local scratch_stack stack;
+}
+
+std::pmr::memory_resource* current_memory_resource() {
+    return current != nullptr ? current : std::pmr::new_delete_resource();
+}
+
+std::pmr::memory_resource* set_memory_resource(std::pmr::memory_resource* r) {
+    std::pmr::memory_resource* previous = current_memory_resource();
+    // the default resource is served by plain operator new
+    current = r == std::pmr::new_delete_resource() ? nullptr : r;
+    return previous;
+}
+
+std::pmr::memory_resource* installed_memory_resource() {
+    return current;
+}
+
+memory_scope::memory_scope(std::pmr::memory_resource* r) : previous(installed_memory_resource()) {
+    set_memory_resource(r);
+}
+
+memory_scope::~memory_scope() {
+    set_memory_resource(previous);
+}
+
+locked_resource::locked_resource(std::pmr::memory_resource* upstream) : upstream(upstream) {}
+
+void* locked_resource::do_allocate(size_t bytes, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return upstream->allocate(bytes, alignment);
+}
+
+void locked_resource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex);
+    upstream->deallocate(p, bytes, alignment);
+}
+
+bool locked_resource::do_is_equal(std::pmr::memory_resource const& other) const noexcept {
+    return this == &other;
+}
+
+namespace scratch {
+    void* allocate(size_t bytes) {
+        return stack.allocate(bytes);
+    }
+
+    void deallocate(void* p, size_t bytes) {
+        stack.deallocate(p, bytes);
+    }
+}
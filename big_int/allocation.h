@@ -0,0 +1,80 @@
+#ifndef ALLOCATION_H
+#define ALLOCATION_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+
+// Memory resource the heap words of big_integer values come from. Each thread has its own,
+// std::pmr::new_delete_resource() until set. Every buffer remembers its resource and is returned to it,
+// so a value may outlive the scope that installed the resource, but not the resource itself.
+// With a std::pmr::monotonic_buffer_resource a whole computation allocates by bumping a pointer
+// and its memory is dropped at once by release(). Tasks of the parallel mode run on the pool threads
+// with the resource of the thread that handed them out, so with parallel::threads() > 1 the resource
+// is used by several threads at once and must be safe for that: wrap an arena in locked_resource.
+std::pmr::memory_resource* current_memory_resource();
+// installs r for the calling thread, null for the default, and returns the previous one
+std::pmr::memory_resource* set_memory_resource(std::pmr::memory_resource* r);
+// the resource set for the calling thread, null for the default one
+std::pmr::memory_resource* installed_memory_resource();
+
+// Installs a resource for the calling thread until the end of the scope.
+struct memory_scope {
+    explicit memory_scope(std::pmr::memory_resource* r);
+    ~memory_scope();
+
+    memory_scope(memory_scope const&) = delete;
+    memory_scope& operator=(memory_scope const&) = delete;
+
+private:
+    std::pmr::memory_resource* previous;
+};
+
+// Passes every call on to upstream under a mutex.
+struct locked_resource : std::pmr::memory_resource {
+    explicit locked_resource(std::pmr::memory_resource* upstream);
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override;
+
+    std::pmr::memory_resource* upstream;
+    std::mutex mutex;
+};
+
+// Thread-local stack for the temporaries of the arithmetic kernels and conversions. Blocks are bumped
+// off a retained chunk, the most recent one is popped when freed, and the whole stack resets when the
+// last block goes. Memory must be freed by the thread that allocated it.
+namespace scratch {
+    void* allocate(size_t bytes);
+    void deallocate(void* p, size_t bytes);
+
+    template <typename T>
+    struct allocator {
+        using value_type = T;
+
+        allocator() = default;
+        template <typename U>
+        allocator(allocator<U> const&) {}
+
+        T* allocate(size_t n) {
+            return static_cast<T*>(scratch::allocate(n * sizeof(T)));
+        }
+        void deallocate(T* p, size_t n) {
+            scratch::deallocate(p, n * sizeof(T));
+        }
+    };
+
+    template <typename T, typename U>
+    bool operator==(allocator<T> const&, allocator<U> const&) {
+        return true;
+    }
+
+    template <typename T, typename U>
+    bool operator!=(allocator<T> const&, allocator<U> const&) {
+        return false;
+    }
+}
+
+#endif // ALLOCATION_H
@@ -0,0 +1,364 @@
+#include "batch.h"
+#include "limbs.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#define BATCH_HAVE_AVX2
+#endif
+
+namespace {
+    // Lane groups for the kernels: every limb is widened to 64 bits so that a 32 x 32 product plus
+    // two limbs fits, and the carry is the high half.
+    struct scalar_lanes {
+        using word = uint64_t;
+        static constexpr size_t COUNT = 1;
+
+        static word load(uint32_t const* p) { return *p; }
+        static void store(uint32_t* p, word x) { *p = static_cast<uint32_t>(x); }
+        static word load_wide(uint64_t const* p) { return *p; }
+        static void store_wide(uint64_t* p, word x) { *p = x; }
+        static word zero() { return 0; }
+        static word add(word x, word y) { return x + y; }
+        static word sub(word x, word y) { return x - y; }
+        static word mul(word x, word y) { return (x & 0xffffffffU) * (y & 0xffffffffU); }
+        static word low(word x) { return x & 0xffffffffU; }
+        static word high(word x) { return x >> 32U; }
+        static word sign(word x) { return x >> 63U; }
+        static word bit_and(word x, word y) { return x & y; }
+        static word bit_andn(word x, word y) { return ~x & y; }
+        static word bit_or(word x, word y) { return x | y; }
+    };
+
+#ifdef BATCH_HAVE_AVX2
+    struct avx2_lanes {
+        using word = __m256i;
+        static constexpr size_t COUNT = 4;
+
+        static word load(uint32_t const* p) {
+            return _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p)));
+        }
+        static void store(uint32_t* p, word x) {
+            __m256i packed = _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(packed));
+        }
+        static word load_wide(uint64_t const* p) { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)); }
+        static void store_wide(uint64_t* p, word x) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x); }
+        static word zero() { return _mm256_setzero_si256(); }
+        static word add(word x, word y) { return _mm256_add_epi64(x, y); }
+        static word sub(word x, word y) { return _mm256_sub_epi64(x, y); }
+        static word mul(word x, word y) { return _mm256_mul_epu32(x, y); }
+        static word low(word x) { return _mm256_and_si256(x, _mm256_set1_epi64x(0xffffffff)); }
+        static word high(word x) { return _mm256_srli_epi64(x, 32); }
+        static word sign(word x) { return _mm256_srli_epi64(x, 63); }
+        static word bit_and(word x, word y) { return _mm256_and_si256(x, y); }
+        static word bit_andn(word x, word y) { return _mm256_andnot_si256(x, y); }
+        static word bit_or(word x, word y) { return _mm256_or_si256(x, y); }
+    };
+#endif
+
+    // f(lanes_type, first_lane) over all lanes, in vector groups first and one by one for the rest
+    template <typename F>
+    void for_lanes(size_t lanes, F f) {
+        size_t j = 0;
+#ifdef BATCH_HAVE_AVX2
+        for (; j + avx2_lanes::COUNT <= lanes; j += avx2_lanes::COUNT) {
+            f(avx2_lanes(), j);
+        }
+#endif
+        for (; j < lanes; ++j) {
+            f(scalar_lanes(), j);
+        }
+    }
+
+    void check_shape(batch const& a, batch const& b) {
+        if (a.lanes() != b.lanes() || a.width() != b.width()) {
+            throw std::runtime_error("Batch shape mismatch");
+        }
+    }
+
+    struct scratch {
+        std::vector<uint64_t> wide;
+        std::vector<uint32_t> limbs;
+    };
+
+    // Montgomery product r = a * b / 2^(32 * w) mod n (CIOS) for the lanes of one group
+    template <typename L>
+    void redc_mul(L, batch& r, batch const& a, batch const& b, batch const& n, uint32_t const* inv,
+                  size_t j, scratch& work) {
+        using word = typename L::word;
+        size_t w = n.width();
+        work.wide.resize((w + 2) * L::COUNT);
+        uint64_t* t = work.wide.data();
+        for (size_t i = 0; i < w + 2; ++i) {
+            L::store_wide(t + i * L::COUNT, L::zero());
+        }
+        word v = L::load(inv + j);
+        for (size_t i = 0; i < w; ++i) {
+            word bi = L::load(b.row(i) + j);
+            word c = L::zero();
+            for (size_t k = 0; k < w; ++k) {
+                word x = L::add(L::add(L::load_wide(t + k * L::COUNT), L::mul(L::load(a.row(k) + j), bi)), c);
+                L::store_wide(t + k * L::COUNT, L::low(x));
+                c = L::high(x);
+            }
+            word x = L::add(L::load_wide(t + w * L::COUNT), c);
+            L::store_wide(t + w * L::COUNT, L::low(x));
+            L::store_wide(t + (w + 1) * L::COUNT, L::high(x));
+
+            word t0 = L::load_wide(t);
+            word q = L::low(L::mul(t0, v));
+            c = L::high(L::add(t0, L::mul(q, L::load(n.row(0) + j))));
+            for (size_t k = 1; k < w; ++k) {
+                x = L::add(L::add(L::load_wide(t + k * L::COUNT), L::mul(q, L::load(n.row(k) + j))), c);
+                L::store_wide(t + (k - 1) * L::COUNT, L::low(x));
+                c = L::high(x);
+            }
+            x = L::add(L::load_wide(t + w * L::COUNT), c);
+            L::store_wide(t + (w - 1) * L::COUNT, L::low(x));
+            L::store_wide(t + w * L::COUNT, L::add(L::load_wide(t + (w + 1) * L::COUNT), L::high(x)));
+        }
+        // t < 2n: subtract n unless that borrows out of the top word
+        word borrow = L::zero();
+        for (size_t k = 0; k < w; ++k) {
+            word x = L::sub(L::sub(L::load_wide(t + k * L::COUNT), L::load(n.row(k) + j)), borrow);
+            borrow = L::sign(x);
+            // the difference goes to r, t keeps the unreduced value for the lanes that stay
+            L::store(r.row(k) + j, x);
+        }
+        word keep = L::bit_andn(L::load_wide(t + w * L::COUNT), borrow);
+        word mask = L::sub(L::zero(), keep);
+        for (size_t k = 0; k < w; ++k) {
+            word x = L::bit_or(L::bit_and(mask, L::load_wide(t + k * L::COUNT)),
+                               L::bit_andn(mask, L::load(r.row(k) + j)));
+            L::store(r.row(k) + j, x);
+        }
+    }
+
+    // A single lane is gathered into contiguous limbs for the ordinary kernels.
+    void redc_mul(scalar_lanes, batch& r, batch const& a, batch const& b, batch const& n, uint32_t const* inv,
+                  size_t j, scratch& work) {
+        size_t w = n.width();
+        work.limbs.assign(5 * w, 0);
+        uint32_t* x = work.limbs.data();
+        uint32_t* y = x + w;
+        uint32_t* m = y + w;
+        uint32_t* t = m + w;
+        for (size_t i = 0; i < w; ++i) {
+            x[i] = a.row(i)[j];
+            y[i] = b.row(i)[j];
+            m[i] = n.row(i)[j];
+        }
+        // step i clears t[i] and leaves the running value in t[i + 1..i + w] plus carry
+        uint32_t carry = 0;
+        for (size_t i = 0; i < w; ++i) {
+            uint64_t top = static_cast<uint64_t>(carry) + limbs::addmul_1(t + i, x, w, y[i]);
+            top += limbs::addmul_1(t + i, m, w, t[i] * inv[j]);
+            t[i + w] = static_cast<uint32_t>(top);
+            carry = static_cast<uint32_t>(top >> 32U);
+        }
+        t += w;
+        if (carry != 0 || limbs::cmp(t, m, w) >= 0) {
+            limbs::sub_n(t, t, m, w);
+        }
+        for (size_t i = 0; i < w; ++i) {
+            r.row(i)[j] = t[i];
+        }
+    }
+
+    // r = a * b column by column, low and high halves of the partial products summed apart
+    template <typename L>
+    void mul_lanes(L, batch& r, batch const& a, batch const& b, size_t j, scratch&) {
+        using word = typename L::word;
+        size_t an = a.width();
+        size_t bn = b.width();
+        word carry = L::zero();
+        for (size_t k = 0; k + 1 < an + bn; ++k) {
+            word lo = L::zero();
+            word hi = L::zero();
+            size_t first = k < bn ? 0 : k - bn + 1;
+            size_t last = std::min(k + 1, an);
+            for (size_t i = first; i < last; ++i) {
+                word p = L::mul(L::load(a.row(i) + j), L::load(b.row(k - i) + j));
+                lo = L::add(lo, L::low(p));
+                hi = L::add(hi, L::high(p));
+            }
+            word x = L::add(lo, carry);
+            L::store(r.row(k) + j, x);
+            carry = L::add(L::high(x), hi);
+        }
+        L::store(r.row(an + bn - 1) + j, carry);
+    }
+
+    void mul_lanes(scalar_lanes, batch& r, batch const& a, batch const& b, size_t j, scratch& work) {
+        size_t an = a.width();
+        size_t bn = b.width();
+        work.limbs.resize(2 * (an + bn));
+        uint32_t* x = work.limbs.data();
+        uint32_t* y = x + an;
+        uint32_t* z = y + bn;
+        for (size_t i = 0; i < an; ++i) {
+            x[i] = a.row(i)[j];
+        }
+        for (size_t i = 0; i < bn; ++i) {
+            y[i] = b.row(i)[j];
+        }
+        limbs::mul(z, x, an, y, bn);
+        for (size_t i = 0; i < an + bn; ++i) {
+            r.row(i)[j] = z[i];
+        }
+    }
+}
+
+batch::batch(size_t lanes, size_t width) : lanes_(lanes), width_(width), limbs_(lanes * width, 0) {}
+
+batch::batch(std::vector<big_integer> const& values, size_t width) : batch(values.size(), width) {
+    for (size_t j = 0; j < values.size(); ++j) {
+        set(j, values[j]);
+    }
+}
+
+size_t batch::lanes() const {
+    return lanes_;
+}
+
+size_t batch::width() const {
+    return width_;
+}
+
+uint32_t* batch::row(size_t i) {
+    return limbs_.data() + i * lanes_;
+}
+
+uint32_t const* batch::row(size_t i) const {
+    return limbs_.data() + i * lanes_;
+}
+
+void batch::set(size_t lane, big_integer const& x) {
+    if (x.sign < 0 || x.words.size() > width_) {
+        throw std::runtime_error("Value does not fit the batch width");
+    }
+    for (size_t i = 0; i < width_; ++i) {
+        row(i)[lane] = i < x.words.size() ? x.words[i] : 0;
+    }
+}
+
+big_integer batch::get(size_t lane) const {
+    size_t n = width_;
+    while (n > 0 && row(n - 1)[lane] == 0) {
+        --n;
+    }
+    storage w(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        w[i] = row(i)[lane];
+    }
+    return big_integer::from_words(1, std::move(w));
+}
+
+std::vector<big_integer> batch::values() const {
+    std::vector<big_integer> res;
+    res.reserve(lanes_);
+    for (size_t j = 0; j < lanes_; ++j) {
+        res.push_back(get(j));
+    }
+    return res;
+}
+
+batch_modulus::batch_modulus(batch const& m) : m(m), r2(m.lanes(), m.width()), inv(m.lanes()) {
+    big_integer r = big_integer(1) << static_cast<int>(64 * m.width());
+    for (size_t j = 0; j < m.lanes(); ++j) {
+        if (m.width() == 0 || (m.row(0)[j] & 1U) == 0) {
+            throw std::runtime_error("Invalid modulus");
+        }
+        r2.set(j, r % m.get(j));
+        inv[j] = limbs::negative_inverse(m.row(0)[j]);
+    }
+}
+
+batch const& batch_modulus::value() const {
+    return m;
+}
+
+void add(batch& r, batch const& a, batch const& b) {
+    check_shape(a, b);
+    check_shape(r, a);
+    for_lanes(a.lanes(), [&](auto lanes, size_t j) {
+        using L = decltype(lanes);
+        auto c = L::zero();
+        for (size_t i = 0; i < a.width(); ++i) {
+            auto x = L::add(L::add(L::load(a.row(i) + j), L::load(b.row(i) + j)), c);
+            L::store(r.row(i) + j, x);
+            c = L::high(x);
+        }
+    });
+}
+
+void sub(batch& r, batch const& a, batch const& b) {
+    check_shape(a, b);
+    check_shape(r, a);
+    for_lanes(a.lanes(), [&](auto lanes, size_t j) {
+        using L = decltype(lanes);
+        auto borrow = L::zero();
+        for (size_t i = 0; i < a.width(); ++i) {
+            auto x = L::sub(L::sub(L::load(a.row(i) + j), L::load(b.row(i) + j)), borrow);
+            L::store(r.row(i) + j, x);
+            borrow = L::sign(x);
+        }
+    });
+}
+
+void mul(batch& r, batch const& a, batch const& b) {
+    if (a.lanes() != b.lanes() || r.lanes() != a.lanes() || r.width() != a.width() + b.width()) {
+        throw std::runtime_error("Batch shape mismatch");
+    }
+    size_t an = a.width();
+    size_t bn = b.width();
+    if (an == 0 || bn == 0) {
+        for (size_t i = 0; i < r.width(); ++i) {
+            std::fill(r.row(i), r.row(i) + r.lanes(), 0);
+        }
+        return;
+    }
+    scratch work;
+    for_lanes(a.lanes(), [&](auto lanes, size_t j) {
+        mul_lanes(lanes, r, a, b, j, work);
+    });
+}
+
+std::vector<int32_t> compare(batch const& a, batch const& b) {
+    check_shape(a, b);
+    std::vector<int32_t> res(a.lanes());
+    for_lanes(a.lanes(), [&](auto lanes, size_t j) {
+        using L = decltype(lanes);
+        auto borrow = L::zero();
+        auto nonzero = L::zero();
+        for (size_t i = 0; i < a.width(); ++i) {
+            auto x = L::sub(L::sub(L::load(a.row(i) + j), L::load(b.row(i) + j)), borrow);
+            borrow = L::sign(x);
+            nonzero = L::bit_or(nonzero, L::low(x));
+        }
+        uint64_t less[L::COUNT];
+        uint64_t differ[L::COUNT];
+        L::store_wide(less, borrow);
+        L::store_wide(differ, nonzero);
+        for (size_t k = 0; k < L::COUNT; ++k) {
+            res[j + k] = less[k] != 0 ? -1 : differ[k] != 0 ? 1 : 0;
+        }
+    });
+    return res;
+}
+
+void modmul(batch& r, batch const& a, batch const& b, batch_modulus const& m) {
+    check_shape(a, b);
+    check_shape(r, a);
+    check_shape(r, m.m);
+    scratch work;
+    // (a b / R) R^2 / R = a b, R = 2^(32 * w)
+    for_lanes(a.lanes(), [&](auto lanes, size_t j) {
+        redc_mul(lanes, r, a, b, m.m, m.inv.data(), j, work);
+        redc_mul(lanes, r, r, m.r2, m.m, m.inv.data(), j, work);
+    });
+}
@@ -0,0 +1,62 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "big_integer.h"
+
+// A fixed number of unsigned values of width limbs each, stored structure-of-arrays: limb i of
+// every lane sits in one contiguous row. The kernels below run the same limb loop for all lanes,
+// four lanes per AVX2 instruction when the target has it (-mavx2 or -march=native), one otherwise.
+struct batch {
+    batch(size_t lanes, size_t width);
+    // values must fit: 0 <= x < 2^(32 * width)
+    batch(std::vector<big_integer> const& values, size_t width);
+
+    size_t lanes() const;
+    size_t width() const;
+
+    void set(size_t lane, big_integer const& x);
+    big_integer get(size_t lane) const;
+    std::vector<big_integer> values() const;
+
+    // limb i of every lane
+    uint32_t* row(size_t i);
+    uint32_t const* row(size_t i) const;
+
+private:
+    size_t lanes_;
+    size_t width_;
+    std::vector<uint32_t> limbs_;
+};
+
+// Odd moduli, one per lane, prepared for Montgomery multiplication.
+struct batch_modulus {
+    explicit batch_modulus(batch const& m);
+
+    batch const& value() const;
+
+    friend void modmul(batch& r, batch const& a, batch const& b, batch_modulus const& m);
+
+private:
+    batch m;
+    // 2^(64 * width) mod m
+    batch r2;
+    // -m^-1 mod 2^32
+    std::vector<uint32_t> inv;
+};
+
+// Lane by lane; a, b and r have the same shape unless stated, and r may be a or b.
+// r = a + b and r = a - b modulo 2^(32 * width)
+void add(batch& r, batch const& a, batch const& b);
+void sub(batch& r, batch const& a, batch const& b);
+// r = a * b in full, r is a.width() + b.width() limbs wide and must not be a or b
+void mul(batch& r, batch const& a, batch const& b);
+// -1, 0 or 1 per lane as a compares to b
+std::vector<int32_t> compare(batch const& a, batch const& b);
+// r = a * b mod m for a and b already reduced
+void modmul(batch& r, batch const& a, batch const& b, batch_modulus const& m);
+
+#endif // BATCH_H
@@ -0,0 +1,121 @@
+// The long_arith assembly kernels against the C++ kernels of limbs, side by side, in nanoseconds
+// per call (best of several runs). The asm kernels take qwords, so they get n / 2 of them.
+// Build limbs without BIG_INTEGER_ASM, so that the C++ column is the C++ code:
+// (cd ../long_arith && ./compile.sh)
+// g++ -std=c++17 -O2 -pthread bench_asm.cpp limbs.cpp allocation.cpp parallel.cpp ../long_arith/liblong_arith.a -o bench_asm
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "limbs.h"
+#include "../long_arith/long_arith.h"
+
+#ifdef BIG_INTEGER_ASM
+#error "bench_asm compares against the C++ kernels; build it without BIG_INTEGER_ASM"
+#endif
+
+namespace {
+    size_t const LIMBS_PER_RUN = size_t(1) << 23U;
+    int const RUNS = 5;
+
+    struct operands {
+        explicit operands(size_t n) : a(n), b(n), r(2 * n) {
+            std::mt19937 gen(n);
+            for (size_t i = 0; i < n; ++i) {
+                a[i] = gen();
+                b[i] = gen() | 1U;
+            }
+        }
+
+        uint64_t* qr() {
+            return reinterpret_cast<uint64_t*>(r.data());
+        }
+        uint64_t const* qa() const {
+            return reinterpret_cast<uint64_t const*>(a.data());
+        }
+        uint64_t const* qb() const {
+            return reinterpret_cast<uint64_t const*>(b.data());
+        }
+
+        std::vector<uint32_t> a;
+        std::vector<uint32_t> b;
+        std::vector<uint32_t> r;
+    };
+
+    // cost of one f(x) on operands of n limbs, work being the limbs it touches
+    template <typename F>
+    double ns_per_call(size_t n, size_t work, F const& f) {
+        operands x(n);
+        size_t reps = LIMBS_PER_RUN / work + 1;
+        double best = 1e300;
+        for (int run = 0; run < RUNS; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t k = 0; k < reps; ++k) {
+                f(x);
+            }
+            std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - start;
+            best = std::min(best, time.count() / static_cast<double>(reps));
+        }
+        return best;
+    }
+
+    template <typename F, typename G>
+    void row(char const* name, std::vector<size_t> const& sizes, bool quadratic, F const& cpp, G const& asm_) {
+        std::printf("%-10s", name);
+        for (size_t n : sizes) {
+            size_t work = quadratic ? n * n : n;
+            double c = ns_per_call(n, work, cpp);
+            double a = ns_per_call(n, work, asm_);
+            std::printf("  %8.1f %8.1f %5.2fx", c, a, c / a);
+        }
+        std::printf("\n");
+    }
+
+    void header(std::vector<size_t> const& sizes) {
+        std::printf("%-10s", "limbs");
+        for (size_t n : sizes) {
+            std::printf("  %24zu", n);
+        }
+        std::printf("\n%-10s", "ns/call");
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            std::printf("  %8s %8s %6s", "c++", "asm", "gain");
+        }
+        std::printf("\n");
+    }
+}
+
+int main() {
+    std::vector<size_t> const linear = {16, 64, 256, 1024};
+    header(linear);
+    row("add", linear, false,
+        [](operands& x) { limbs::add_n(x.r.data(), x.a.data(), x.b.data(), x.a.size()); },
+        [](operands& x) { add_long_long(x.qr(), x.qa(), x.qb(), x.a.size() / 2); });
+    row("sub", linear, false,
+        [](operands& x) { limbs::sub_n(x.r.data(), x.a.data(), x.b.data(), x.a.size()); },
+        [](operands& x) { sub_long_long(x.qr(), x.qa(), x.qb(), x.a.size() / 2); });
+    row("mul_1", linear, false,
+        [](operands& x) { limbs::mul_1(x.r.data(), x.a.data(), x.a.size(), x.b[0]); },
+        [](operands& x) { mul_long_short(x.qr(), x.qa(), x.a.size() / 2, x.b[0]); });
+    row("addmul_1", linear, false,
+        [](operands& x) { limbs::addmul_1(x.r.data(), x.a.data(), x.a.size(), x.b[0]); },
+        [](operands& x) { add_mul_long_short(x.qr(), x.qa(), x.a.size() / 2, x.b[0]); });
+    row("submul_1", linear, false,
+        [](operands& x) { limbs::submul_1(x.r.data(), x.a.data(), x.a.size(), x.b[0]); },
+        [](operands& x) { sub_mul_long_short(x.qr(), x.qa(), x.a.size() / 2, x.b[0]); });
+    row("divrem_1", linear, false,
+        [](operands& x) { limbs::divrem_1(x.r.data(), x.a.data(), x.a.size(), x.b[0]); },
+        [](operands& x) { div_long_short(x.qr(), x.qa(), x.a.size() / 2, x.b[0], 0); });
+
+    // schoolbook range: limbs::mul switches to Karatsuba from 48 limbs
+    std::vector<size_t> const basecase = {4, 8, 16, 32, 46};
+    std::printf("\n");
+    header(basecase);
+    row("mul", basecase, true,
+        [](operands& x) { limbs::mul(x.r.data(), x.a.data(), x.a.size(), x.b.data(), x.b.size()); },
+        [](operands& x) { mul_long_long(x.qr(), x.qa(), x.a.size() / 2, x.qb(), x.b.size() / 2); });
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Throughput of the add/sub carry-chain kernels (and the multiply rows for comparison) in 32-bit
+// limbs per TSC cycle, best of several runs. Needs an x86-64 target.
+// g++ -std=c++17 -O2 -pthread bench_limbs.cpp limbs.cpp allocation.cpp parallel.cpp -o bench_limbs
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <x86intrin.h>
+
+#include "limbs.h"
+
+namespace {
+    size_t const LIMBS_PER_RUN = size_t(1) << 24U;
+    int const RUNS = 5;
+
+    // f(r, a, b, n) repeated over LIMBS_PER_RUN limbs
+    template <typename F>
+    double limbs_per_cycle(size_t n, F const& f) {
+        std::mt19937 gen(n);
+        std::vector<uint32_t> a(n);
+        std::vector<uint32_t> b(n);
+        std::vector<uint32_t> r(n + 1);
+        for (size_t i = 0; i < n; ++i) {
+            a[i] = gen();
+            b[i] = gen();
+        }
+        size_t reps = LIMBS_PER_RUN / n + 1;
+        uint64_t best = UINT64_MAX;
+        uint32_t sink = 0;
+        for (int run = 0; run < RUNS; ++run) {
+            uint64_t start = __rdtsc();
+            for (size_t k = 0; k < reps; ++k) {
+                sink += f(r.data(), a.data(), b.data(), n);
+            }
+            best = std::min<uint64_t>(best, __rdtsc() - start);
+        }
+        r[n] = sink;
+        return static_cast<double>(n * reps) / static_cast<double>(best);
+    }
+}
+
+int main() {
+    size_t const sizes[] = {4, 16, 64, 256, 1024, 4096};
+    std::printf("%-22s", "limbs per cycle");
+    for (size_t n : sizes) {
+        std::printf("%8zu", n);
+    }
+    std::printf("\n");
+
+    auto row = [&](char const* name, auto const& f) {
+        std::printf("%-22s", name);
+        for (size_t n : sizes) {
+            std::printf("%8.2f", limbs_per_cycle(n, f));
+        }
+        std::printf("\n");
+    };
+    row("add_n", [](uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n) {
+        return limbs::add_n(r, a, b, n);
+    });
+    row("sub_n", [](uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n) {
+        return limbs::sub_n(r, a, b, n);
+    });
+    row("add_n in place", [](uint32_t* r, uint32_t const*, uint32_t const* b, size_t n) {
+        return limbs::add_n(r, r, b, n);
+    });
+    // a half-length second operand, the carry running through the upper half of the first
+    std::vector<uint32_t> const ones(sizes[5], UINT32_MAX);
+    std::vector<uint32_t> const zeroes(sizes[5], 0);
+    row("add, carry through", [&ones](uint32_t* r, uint32_t const*, uint32_t const* b, size_t n) {
+        return limbs::add(r, ones.data(), n, b, (n + 1) / 2);
+    });
+    row("sub, borrow through", [&zeroes](uint32_t* r, uint32_t const*, uint32_t const* b, size_t n) {
+        return limbs::sub(r, zeroes.data(), n, b, (n + 1) / 2);
+    });
+    row("addmul_1", [](uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n) {
+        return limbs::addmul_1(r, a, n, b[0]);
+    });
+    row("submul_1", [](uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n) {
+        return limbs::submul_1(r, a, n, b[0]);
+    });
+    return 0;
+}
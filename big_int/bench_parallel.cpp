@@ -0,0 +1,89 @@
+// Scaling of the parallel mode: huge products, a division and both decimal conversions timed at
+// 1, 2, 4 and hardware_concurrency() threads, with the speedup over one thread.
+// g++ -std=c++17 -O2 -pthread bench_parallel.cpp big_integer.cpp limbs.cpp storage.cpp allocation.cpp parallel.cpp -o bench_parallel
+// ./bench_parallel [limbs]   (operand size, 1 << 20 by default)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "big_integer.h"
+#include "parallel.h"
+
+namespace {
+    big_integer random_value(size_t words, uint32_t seed) {
+        std::mt19937 gen(seed);
+        std::vector<uint32_t> magnitude(words);
+        for (uint32_t& w : magnitude) {
+            w = gen();
+        }
+        magnitude[0] |= 1U << 31U;
+        return big_integer(1, magnitude);
+    }
+
+    // best of two runs, in milliseconds
+    double time_ms(std::function<void()> const& f) {
+        double best = 1e300;
+        for (int run = 0; run < 2; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+            best = std::min(best, time.count());
+        }
+        return best;
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t words = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : size_t(1) << 20U;
+    size_t hardware = std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::vector<size_t> counts = {1, 2, 4, hardware};
+    std::sort(counts.begin(), counts.end());
+    counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+
+    big_integer a = random_value(words, 1);
+    big_integer b = random_value(words, 2);
+    big_integer half = random_value(words / 2, 3);
+    big_integer product = a * b;
+    std::string decimal = to_string(a);
+
+    struct job {
+        char const* name;
+        std::function<void()> f;
+    };
+    big_integer sink;
+    std::vector<job> jobs = {
+        {"a * b", [&] { sink = a * b; }},
+        {"a * a", [&] { sink = a; sink *= a; }},
+        {"a * b / half", [&] { sink = product / half; }},
+        {"to_string(a)", [&] { decimal = to_string(a); }},
+        {"parse", [&] { sink = big_integer(decimal); }},
+    };
+
+    std::printf("%zu-limb operands, %zu hardware threads\n%-14s", words, hardware, "ms (speedup)");
+    for (size_t t : counts) {
+        std::printf("%16zu thr", t);
+    }
+    std::printf("\n");
+    for (job const& j : jobs) {
+        std::printf("%-14s", j.name);
+        double base = 0;
+        for (size_t t : counts) {
+            parallel::set_threads(t);
+            double ms = time_ms(j.f);
+            if (t == 1) {
+                base = ms;
+            }
+            std::printf("%11.1f (%5.2fx)", ms, base / ms);
+        }
+        std::printf("\n");
+    }
+    parallel::set_threads(1);
+    return 0;
+}
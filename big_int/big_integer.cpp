@@ -1,12 +1,79 @@
 #include "big_integer.h"
+#include "limbs.h"
+#include "allocation.h"
+#include "parallel.h"
 
 #include <cstring>
 #include <stdexcept>
 #include <algorithm>
 #include <utility>
 #include <functional>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+// Decimal conversions work on chunks of DECIMAL_DIGITS digits, one 32-bit word each.
+static uint32_t const DECIMAL_BASE = 1000000000;
+static size_t const DECIMAL_DIGITS = 9;
+// Number of chunks below which the string is parsed by repeated multiply-add.
+static size_t const PARSE_THRESHOLD = 32;
+// Number of words below which digits are peeled off by repeated short division.
+static size_t const TO_STRING_THRESHOLD = 32;
+// Enough 10^9 chunks for any value of TO_STRING_THRESHOLD words (32 * log10(2) / 9 < 1.1 chunks per word).
+static size_t const MAX_BASECASE_CHUNKS = TO_STRING_THRESHOLD * 11 / 10 + 2;
+// Number of words from which the two halves of a conversion are computed in parallel, when enabled.
+static size_t const PARALLEL_CONVERSION_THRESHOLD = 20000;
+// Most digits held back while the high half of a parallel decimal output is still going out; splits
+// with a longer low half are emitted in order, so only the levels below run in parallel.
+static size_t const PARALLEL_BUFFER_DIGITS = size_t(1) << 20U;
+
+// 10^(DECIMAL_DIGITS * 2^level), computed once and shared; kept on the default heap, since the
+// cache outlives whatever memory_resource the caller has installed
+static big_integer const& decimal_power(size_t level) {
+    static std::mutex mutex;
+    static std::deque<big_integer> powers;
+    std::lock_guard<std::mutex> lock(mutex);
+    memory_scope scope(nullptr);
+    if (powers.empty()) {
+        powers.emplace_back(DECIMAL_BASE);
+    }
+    while (powers.size() <= level) {
+        big_integer next = powers.back();
+        next *= next;
+        powers.push_back(std::move(next));
+    }
+    return powers[level];
+}
+
+magnitude_view::magnitude_view(uint32_t const* words, size_t count) : words(words), count(count) {}
+
+magnitude_view::const_iterator magnitude_view::begin() const {
+    return const_iterator(words + count);
+}
+
+magnitude_view::const_iterator magnitude_view::end() const {
+    return const_iterator(words);
+}
+
+size_t magnitude_view::size() const {
+    return count;
+}
+
+bool magnitude_view::empty() const {
+    return count == 0;
+}
+
+uint32_t magnitude_view::operator[](size_t i) const {
+    return words[count - 1 - i];
+}
+
+magnitude_view::operator std::vector<uint32_t>() const {
+    return std::vector<uint32_t>(begin(), end());
+}
 
-big_integer::big_integer(int32_t sign, std::vector<uint32_t> const& words) : data(words) {
+big_integer::big_integer(int32_t sign, std::vector<uint32_t> const& magnitude) : words(magnitude.size(), 0) {
+    std::reverse_copy(magnitude.begin(), magnitude.end(), words.begin());
     this->sign = sign;
 }
 
@@ -14,17 +81,23 @@ big_integer::big_integer() {
     sign = 0;
 }
 
-big_integer::big_integer(big_integer const& other) : data(other.data) {
+big_integer::big_integer(big_integer const& other) : words(other.words) {
     sign = other.sign;
 }
 
+big_integer::big_integer(big_integer&& other) noexcept : words(std::move(other.words)) {
+    sign = other.sign;
+    other.words.clear();
+    other.sign = 0;
+}
+
 big_integer::big_integer(std::vector<uint32_t> const& other) : big_integer(1, other) {}
 
 big_integer::big_integer(int a) {
     int32_t signum = 0;
     if (a != 0) {
         signum = a < 0? -1 : 1;
-        data.push_back(signum * a);
+        words.push_back(signum * a);
     }
     sign = signum;
 }
@@ -33,159 +106,242 @@ big_integer::big_integer(uint32_t a) {
     int32_t signum = 0;
     if (a != 0) {
         signum = 1;
-        data.push_back(a);
+        words.push_back(a);
     }
     sign = signum;
 }
 
 
-big_integer::big_integer(std::string const& str) : big_integer() {
-    size_t len = str.size();
-    if (len == 0) {
-        throw std::runtime_error("Invalid string");
+// Digits of radices 2 to 32, also accepted in upper case when parsing.
+static char const RADIX_DIGITS[] = "0123456789abcdefghijklmnopqrstuv";
+
+// log2(radix) for the power-of-two radices, 0 for decimal
+static uint32_t radix_bits(int radix) {
+    if (radix == 10) {
+        return 0;
+    }
+    for (uint32_t bits = 1; bits <= 5; ++bits) {
+        if (radix == (1 << bits)) {
+            return bits;
+        }
+    }
+    throw std::runtime_error("Unsupported radix");
+}
+
+static uint32_t digit_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
     }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A' + 10;
+    }
+    return 36;
+}
+
+big_integer::big_integer(std::string const& str) : big_integer(str, 10) {}
+
+big_integer::big_integer(std::string const& str, int radix) : big_integer() {
+    uint32_t bits = radix_bits(radix);
+    size_t len = str.size();
     size_t ptr = 0;
-    while (str[0] == ' ') {
+    while (ptr < len && str[ptr] == ' ') {
         ++ptr;
     }
     int32_t signum = 1;
-    if (str[ptr] == '-') {
+    if (ptr < len && str[ptr] == '-') {
         signum = -1;
         ++ptr;
-    } else if (str[ptr] == '+') {
+    } else if (ptr < len && str[ptr] == '+') {
         ++ptr;
     }
-    while (str[ptr] == '0') {
+    if (ptr == len) {
+        throw std::runtime_error("Invalid string");
+    }
+    for (size_t i = ptr; i < len; ++i) {
+        if (digit_value(str[i]) >= static_cast<uint32_t>(radix)) {
+            throw std::runtime_error("Invalid string");
+        }
+    }
+    while (ptr < len && str[ptr] == '0') {
         ptr++;
     }
-    *this = 0;
-    if (ptr == len) {
-        signum = 0;
-    } else {
-        while (ptr < len) {
-            if (str[ptr] < '0' || str[ptr] > '9') {
-                throw std::runtime_error("Invalid string");
+    if (bits != 0) {
+        // every digit lands on its own bits, so this is a single linear pass
+        storage res(((len - ptr) * bits + 31) / 32, 0);
+        size_t pos = 0;
+        for (size_t i = len; i > ptr; --i, pos += bits) {
+            uint32_t value = digit_value(str[i - 1]);
+            size_t offset = pos % 32;
+            res[pos / 32] |= value << offset;
+            if (offset + bits > 32) {
+                res[pos / 32 + 1] |= value >> (32 - offset);
             }
-            *this *= 10;
-            *this += static_cast<int>(str[ptr] - '0');
-            ++ptr;
         }
-    }
-    sign = signum;
-}
-
-size_t big_integer::size() const {
-    return data.size();
-}
-
-static int32_t compare_abs(std::vector<uint32_t> const& words, std::vector<uint32_t> const& other_words) {
-    if (words.size() == other_words.size()) {
-        size_t ptr = 0;
-        while (ptr < words.size() && words[ptr] == other_words[ptr]) {
-            ptr++;
+        while (!res.empty() && res.back() == 0) {
+            res.pop_back();
         }
-        if (ptr == words.size()) {
-            return 0;
+        *this = from_words(signum, std::move(res));
+        return;
+    }
+    std::vector<uint32_t, scratch::allocator<uint32_t>> chunks((len - ptr + DECIMAL_DIGITS - 1) / DECIMAL_DIGITS);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        size_t end = len - i * DECIMAL_DIGITS;
+        size_t begin = end - std::min(DECIMAL_DIGITS, end - ptr);
+        uint32_t chunk = 0;
+        for (size_t k = begin; k < end; ++k) {
+            chunk = chunk * 10 + (str[k] - '0');
         }
-        return (words[ptr] < other_words[ptr])? -1 : 1;
+        chunks[i] = chunk;
     }
-    return (words.size() < other_words.size())? -1 : 1;
-}
-
-static uint32_t get_word(std::vector<uint32_t> const& val, size_t n) {
-    if (n >= val.size()) {
-        return 0;
+    *this = from_chunks(chunks.data(), chunks.size());
+    sign *= signum;
+}
+
+big_integer big_integer::from_chunks(uint32_t const* chunks, size_t count) {
+    if (count <= PARSE_THRESHOLD) {
+        storage acc(count, 0);
+        size_t m = 0;
+        for (size_t i = count; i > 0; --i) {
+            uint64_t carry = chunks[i - 1];
+            for (size_t j = 0; j < m; ++j) {
+                carry += static_cast<uint64_t>(acc[j]) * DECIMAL_BASE;
+                acc[j] = static_cast<uint32_t>(carry);
+                carry >>= 32U;
+            }
+            if (carry != 0) {
+                acc[m++] = static_cast<uint32_t>(carry);
+            }
+        }
+        acc.resize(m);
+        return from_words(1, std::move(acc));
     }
-    return val[val.size() - n - 1];
-}
-
-static void remove_zeroes(std::vector<uint32_t>& v) {
-    if (v.empty()) {
-        return;
+    size_t level = 0;
+    while ((size_t(2) << level) < count) {
+        ++level;
     }
-    size_t ptr = 0;
-    while (ptr < v.size() && v[ptr] == 0) {
-        ptr++;
-    }
-    if (ptr == v.size()) {
-        v.resize(0);
-        return;
+    size_t half = size_t(1) << level;
+    big_integer const& power = decimal_power(level);
+    big_integer res;
+    big_integer low;
+    auto high_part = [&] {
+        res = from_chunks(chunks + half, count - half);
+        res *= power;
+    };
+    auto low_part = [&] {
+        low = from_chunks(chunks, half);
+    };
+    if (count >= PARALLEL_CONVERSION_THRESHOLD && parallel::threads() > 1) {
+        parallel::invoke(high_part, low_part);
+    } else {
+        high_part();
+        low_part();
     }
-    v.resize(std::move(v.begin() + ptr, v.end(), v.begin()) - v.begin());
-}
-
-uint64_t add(uint32_t a, uint32_t b) {
-    return static_cast<uint64_t>(a) + b;
-}
-
-uint64_t sub(uint32_t a, uint32_t b) {
-    return static_cast<uint64_t>(a) - b;
+    res += low;
+    return res;
 }
 
-static void apply_arithmetic(std::vector<uint32_t>& a, std::vector<uint32_t> const& b,
-                             size_t start, std::function<uint64_t(uint32_t, uint32_t)> op) {
-    int32_t carry = 0;
-    uint64_t ss = (1Ull << 32ULL);
-    for (size_t i = start; i < a.size(); ++i) {
-        uint64_t swc = op(get_word(a, i), get_word(b, i - start)) + carry;
-        a[a.size() - i - 1] = (swc % ss);
-        carry = swc / ss;
-    }
+big_integer big_integer::from_words(int32_t sign, storage&& words) {
+    big_integer res;
+    res.words = std::move(words);
+    res.sign = res.words.empty() ? 0 : sign;
+    return res;
 }
 
-static void add_long(std::vector<uint32_t>& a, std::vector<uint32_t> const& b, size_t start) {
-    apply_arithmetic(a, b, start, add);
+magnitude_view big_integer::data() const {
+    return magnitude_view(words.data(), words.size());
 }
 
-static void subtract_long(std::vector<uint32_t>& a, std::vector<uint32_t> const& b, size_t start) {
-    apply_arithmetic(a, b, start, sub);
+size_t big_integer::size() const {
+    return words.size();
 }
 
-static std::vector<uint32_t> apply_add_long(std::vector<uint32_t> const& a, std::vector<uint32_t> const &b) {
-    std::vector<uint32_t> res(std::max(a.size(), b.size()) + 1, 0);
-    add_long(res, a, 0);
-    add_long(res, b, 0);
-    remove_zeroes(res);
-    return res;
+static int32_t compare_abs(storage const& words, storage const& other_words) {
+    if (words.size() == other_words.size()) {
+        size_t ptr = words.size();
+        while (ptr > 0 && words[ptr - 1] == other_words[ptr - 1]) {
+            ptr--;
+        }
+        if (ptr == 0) {
+            return 0;
+        }
+        return (words[ptr - 1] < other_words[ptr - 1])? -1 : 1;
+    }
+    return (words.size() < other_words.size())? -1 : 1;
 }
 
-static std::vector<uint32_t> apply_subtract_long(std::vector<uint32_t> const& a, std::vector<uint32_t> const &b) {
-    std::vector<uint32_t> res(std::max(a.size(), b.size()) + 4, 0);
-    add_long(res, a, 0);
-    subtract_long(res, b, 0);
-    remove_zeroes(res);
-    return res;
+static void remove_zeroes(storage& v) {
+    while (!v.empty() && v.back() == 0) {
+        v.pop_back();
+    }
 }
 
-big_integer& big_integer::add_signed(int32_t rhs_sign, std::vector<uint32_t> const& rhs_words) {
-    std::vector<uint32_t> _words = this->data;
+big_integer& big_integer::add_signed(int32_t rhs_sign, storage const& rhs_words) {
     if (rhs_sign == 0) {
         return *this;
     } else if (sign == 0) {
         sign = rhs_sign;
-        _words = rhs_words;
+        words = rhs_words;
     } else if (sign == rhs_sign) {
-        _words = apply_add_long(_words, rhs_words);
+        if (&rhs_words == &words) {
+            return (*this <<= 1);
+        }
+        if (words.size() == 1 && rhs_words.size() == 1) {
+            uint64_t sum = static_cast<uint64_t>(words[0]) + rhs_words[0];
+            words[0] = static_cast<uint32_t>(sum);
+            if (sum >> 32U) {
+                words.push_back(1);
+            }
+            return *this;
+        }
+        size_t n = words.size();
+        if (n < rhs_words.size()) {
+            words.resize(rhs_words.size(), 0);
+            n = rhs_words.size();
+        }
+        if (limbs::add(words.data(), words.data(), n, rhs_words.data(), rhs_words.size()) != 0) {
+            words.push_back(1);
+        }
+    } else if (words.size() == 1 && rhs_words.size() == 1) {
+        uint32_t x = words[0];
+        uint32_t y = rhs_words[0];
+        if (x == y) {
+            words.clear();
+            sign = 0;
+        } else if (x > y) {
+            words[0] = x - y;
+        } else {
+            words[0] = y - x;
+            sign = rhs_sign;
+        }
     } else {
-        int32_t cmp = compare_abs(_words, rhs_words);
+        int32_t cmp = compare_abs(words, rhs_words);
         if (cmp == 0) {
-            _words.clear();
+            words.clear();
             sign = 0;
         } else {
-            _words = cmp > 0 ? apply_subtract_long(_words, rhs_words) : apply_subtract_long(rhs_words, _words);
+            if (cmp > 0) {
+                limbs::sub(words.data(), words.data(), words.size(), rhs_words.data(), rhs_words.size());
+            } else {
+                size_t n = words.size();
+                words.resize(rhs_words.size(), 0);
+                limbs::sub(words.data(), rhs_words.data(), rhs_words.size(), words.data(), n);
+            }
+            remove_zeroes(words);
             sign = sign == cmp? 1 : -1;
         }
     }
-    data = _words;
     return *this;
 }
 
 big_integer& big_integer::operator+=(big_integer const& rhs) {
-    return add_signed(rhs.sign, rhs.data);
+    return add_signed(rhs.sign, rhs.words);
 }
 
 big_integer& big_integer::operator-=(big_integer const& rhs) {
-    return add_signed(-rhs.sign, rhs.data);
+    return add_signed(-rhs.sign, rhs.words);
 }
 
 big_integer& big_integer::operator*=(big_integer const& rhs) {
@@ -195,234 +351,250 @@ big_integer& big_integer::operator*=(big_integer const& rhs) {
     if (sign == 0) {
         return *this;
     }
-    int32_t signum = sign * rhs.sign;
-    std::vector<uint32_t> a(data);
-    std::vector<uint32_t> b(rhs.data);
-    a.insert(a.begin(), 0);
-    b.insert(b.begin(), 0);
-    std::vector<uint32_t> tmp(a.size() + b.size() + 1, 0);
-    for (size_t i = 0; i < b.size(); i++) {
-        uint64_t carry = 0;
-        for (size_t j = 0; j < a.size(); j++) {
-            size_t index = i + j;
-            carry += static_cast<uint64_t>(b[b.size() - i - 1]) * (j < a.size() ? a[a.size() - j - 1] : 0) + tmp[tmp.size() - index - 1];
-            tmp[tmp.size() - index - 1] = carry;
-            carry >>= 32u;
+    if (size() == 1 && rhs.size() == 1) {
+        uint64_t prod = static_cast<uint64_t>(words[0]) * rhs.words[0];
+        words[0] = static_cast<uint32_t>(prod);
+        if (prod >> 32U) {
+            words.push_back(static_cast<uint32_t>(prod >> 32U));
         }
+        sign *= rhs.sign;
+        return *this;
+    }
+    storage tmp(size() + rhs.size(), 0);
+    if (this == &rhs) {
+        limbs::sqr(tmp.data(), words.data(), size());
+    } else {
+        limbs::mul(tmp.data(), words.data(), size(), rhs.words.data(), rhs.size());
     }
     remove_zeroes(tmp);
-    return (*this = big_integer(signum, tmp));
+    words.swap(tmp);
+    sign *= rhs.sign;
+    return *this;
 }
 
-bool big_integer::smaller(big_integer const &a, big_integer const &b, size_t index) {
-    for (size_t i = 1; i <= a.size(); i++) {
-        if (get_word(a.data, a.size() - i) != (index - i < b.size() ? get_word(b.data, index - i) : 0)) {
-            return get_word(a.data, a.size() - i) > (index - i < b.size() ? get_word(b.data, index - i) : 0);
-        }
+big_integer& big_integer::add_product(int32_t product_sign, big_integer const& a, big_integer const& b) {
+    if (product_sign == 0) {
+        return *this;
     }
-    return true;
-}
-
-void big_integer::difference(big_integer &a, big_integer const &b, size_t index) {
-    if (a.size() < index) {
-        return;
+    if (this == &a || this == &b) {
+        big_integer prod = a * b;
+        return add_signed(product_sign, prod.words);
     }
-    size_t start = a.size() - index;
-    uint32_t borrow = 0;
-    for (size_t i = 0; i < index; ++i) {
-        uint32_t x = get_word(a.data, start + i);
-        uint32_t y = (i < b.size() ? get_word(b.data, i) : 0);
-        uint64_t c = static_cast<int64_t>(x) - y - borrow;
-        borrow = (y + borrow > x);
-        c &= UINT32_MAX;
-        if (a.size() >= start + i + 1) {
-            a.data[a.size() - start - i - 1] = c;
+    size_t n = std::max(size(), a.size() + b.size()) + 1;
+    words.resize(n, 0);
+    if (sign == 0 || sign == product_sign) {
+        limbs::addmul(words.data(), n, a.words.data(), a.size(), b.words.data(), b.size());
+        sign = product_sign;
+    } else if (limbs::submul(words.data(), n, a.words.data(), a.size(), b.words.data(), b.size()) != 0) {
+        // |r| < |ab|: the limbs hold B^n - (|ab| - |r|)
+        for (uint32_t& w : words) {
+            w = ~w;
         }
+        uint32_t const one = 1;
+        limbs::add(words.data(), words.data(), n, &one, 1);
+        sign = product_sign;
     }
+    remove_zeroes(words);
+    if (words.empty()) {
+        sign = 0;
+    }
+    return *this;
 }
 
-big_integer big_integer::shortdiv(big_integer const &lhs, uint32_t rhs) {
-    std::vector<uint32_t> tmp(lhs.size());
-    uint64_t rest = 0;
-    uint64_t x = 0;
-    for (size_t i = 0; i < lhs.size(); i++) {
-        x = (rest << 32U) | lhs.data[i];
-        tmp[i] = static_cast<uint32_t>(x / rhs);
-        rest = x % rhs;
-    }
-    remove_zeroes(tmp);
-    return big_integer(tmp);
+void addmul(big_integer& r, big_integer const& a, big_integer const& b) {
+    r.add_product(a.sign * b.sign, a, b);
 }
 
-big_integer& big_integer::operator/=(big_integer const &other) {
-    int32_t signum = this->sign * other.sign;
-    big_integer divident = *this;
-    big_integer divisor = other;
-    divident.sign = divisor.sign = 1;
-    if (divident < divisor) {
-        return (*this = 0);
-    }
-    if (divisor.size() == 1) {
-        *this = shortdiv(divident, divisor.data[0]);
-        sign = signum;
-        return *this;
+void submul(big_integer& r, big_integer const& a, big_integer const& b) {
+    r.add_product(-a.sign * b.sign, a, b);
+}
+
+std::pair<big_integer, big_integer> divmod(big_integer const& a, big_integer const& b) {
+    if (b.sign == 0) {
+        throw std::runtime_error("Division by zero");
     }
-    uint32_t f = (static_cast<uint64_t>(UINT32_MAX) + 1)
-                 / (static_cast<uint64_t>(divisor.data[0]) + 1);
-    divident *= f;
-    divisor *= f;
-    divident.data.insert(divident.data.begin(), 0);
-    size_t m = divisor.size() + 1;
-    size_t n = divident.size();
-    data.resize(n - m + 1);
-    for (size_t i = m, j = size() - 1; i <= n; ++i, --j) {
-        __uint128_t x = (((__uint128_t) get_word(divident.data, divident.size() - 1) << 64U) +
-                         ((__uint128_t) get_word(divident.data, divident.size() - 2) << 32U) +
-                         ((__uint128_t) get_word(divident.data, divident.size() - 3)));
-        __uint128_t y = (((__uint128_t) divisor.data[0] << 32U) +
-                         (__uint128_t) divisor.data[1]);
-        uint32_t qt = std::min(static_cast<uint32_t>(x / y), UINT32_MAX);
-        big_integer dq = divisor * qt;
-        if (!smaller(divident, dq, m)) {
-            qt--;
-            dq -= divisor;
-        }
-        data[size() - j - 1] = qt;
-        difference(divident, dq, m);
-        remove_zeroes(divident.data);
+    if (compare_abs(a.words, b.words) < 0) {
+        return {0, a};
     }
-    remove_zeroes(data);
-    sign = signum;
-    return *this;
+    storage q(a.size() - b.size() + 1, 0);
+    storage r(b.size(), 0);
+    limbs::divrem(q.data(), r.data(), a.words.data(), a.size(), b.words.data(), b.size());
+    remove_zeroes(q);
+    remove_zeroes(r);
+    return {big_integer::from_words(a.sign * b.sign, std::move(q)), big_integer::from_words(a.sign, std::move(r))};
+}
+
+big_integer& big_integer::operator/=(big_integer const& rhs) {
+    return (*this = divmod(*this, rhs).first);
 }
 
 big_integer& big_integer::operator%=(big_integer const& rhs) {
-    *this -= (*this / rhs) * rhs;
-    return *this;
+    return (*this = divmod(*this, rhs).second);
 }
 
-static size_t not_zero_id(std::vector<uint32_t> const& value) {
-    for (size_t i = value.size(); i > 0; --i) {
-        if (value[i - 1] != 0) {
-            return value.size() - i;
+static size_t not_zero_id(storage const& value) {
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] != 0) {
+            return i;
         }
     }
     return value.size();
 }
 
-uint32_t big_integer::get_signed(size_t id, size_t not_zero_pos) const {
-    if (sign == 0) {
-        return 0;
+enum class bit_kernel { and_n, ior_n, xor_n, andn_n };
+
+// r = a op b on zero-extended magnitudes: and_n writes min(an, bn) limbs, andn_n an limbs, the others max(an, bn)
+static void apply_bitwise(bit_kernel k, uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+    size_t n = std::min(an, bn);
+    switch (k) {
+        case bit_kernel::and_n:
+            limbs::and_n(r, a, b, n);
+            return;
+        case bit_kernel::andn_n:
+            limbs::andn_n(r, a, b, n);
+            std::copy(a + n, a + an, r + n);
+            return;
+        case bit_kernel::ior_n:
+            limbs::ior_n(r, a, b, n);
+            break;
+        case bit_kernel::xor_n:
+            limbs::xor_n(r, a, b, n);
+            break;
     }
-    if (id > data.size()) {
-        return sign == 1? 0 : -1;
-    } else if (id == data.size()) {
-        uint32_t word = 0;
-        return sign == 1? word : (id <= not_zero_pos? -word : ~word);
+    if (an > n) {
+        std::copy(a + n, a + an, r + n);
     } else {
-        uint32_t word = data[data.size() - id - 1];
-        return sign == 1? word : (id <= not_zero_pos? -word : ~word);
+        std::copy(b + n, b + bn, r + n);
     }
 }
 
-static big_integer get_value(std::vector<uint32_t>& value) {
-    if (!value.empty() && value[0] >> 31u) {
-        for (unsigned int & i : value) {
-            i = ~i;
-        }
-        remove_zeroes(value);
-        return big_integer(-1, value) - 1;
+// n low limbs of |w| - 1 (of |w| when dec is false), zero-extended
+static storage low_words(storage const& w, size_t n, bool dec) {
+    storage res(w.begin(), w.begin() + std::min(n, w.size()));
+    res.resize(n, 0);
+    if (dec) {
+        uint32_t const one = 1;
+        limbs::sub(res.data(), res.data(), n, &one, 1);
     }
-    remove_zeroes(value);
-    if (value.empty()) {
-        return 0;
-    }
-    return big_integer(value);
+    return res;
 }
 
-
-big_integer& big_integer::bit_operation(big_integer const& rhs,
-        std::function<uint32_t(uint32_t, uint32_t)> const& op) {
-    std::vector<uint32_t> result(std::max(data.size(), rhs.data.size()) + 1);
-    size_t pos1 = not_zero_id(data);
-    size_t pos2 = not_zero_id(rhs.data);
-    for (size_t i = 0; i < result.size(); ++i) {
-        result[i] = op(get_signed(result.size() - i - 1, pos1),
-                       rhs.get_signed(result.size() - i - 1, pos2));
+// A negative x is ~(|x| - 1) in two's complement, so every case is one kernel on the magnitudes
+// (minus one for negative operands), negated as -(r + 1) when the result is negative. |x| - 1 only
+// differs from |x| up to its lowest nonzero word: the kernel runs on the stored words and those
+// few low words are redone afterwards.
+big_integer& big_integer::bit_operation(big_integer const& rhs, bit_op op) {
+    storage const* p = &words;
+    storage const* q = &rhs.words;
+    bool p_neg = sign < 0;
+    bool q_neg = rhs.sign < 0;
+    bit_kernel k = bit_kernel::xor_n;
+    bool negative = p_neg != q_neg;
+    if (op != bit_op::xor_op) {
+        bool is_and = op == bit_op::and_op;
+        if (p_neg == q_neg) {
+            // ~p & ~q = ~(p | q) and ~p | ~q = ~(p & q)
+            k = is_and == p_neg ? bit_kernel::ior_n : bit_kernel::and_n;
+            negative = p_neg;
+        } else {
+            // with p the negative operand: q & ~p is positive, ~p | q = ~(p & ~q) negative
+            if (p_neg == is_and) {
+                std::swap(p, q);
+                std::swap(p_neg, q_neg);
+            }
+            k = bit_kernel::andn_n;
+            negative = !is_and;
+        }
     }
-    *this = get_value(result);
-    return *this;
-}
-
-uint32_t bit_and(uint32_t a, uint32_t b) {
-    return a & b;
-}
-
-uint32_t bit_or(uint32_t a, uint32_t b) {
-    return a | b;
-}
-
-uint32_t bit_xor(uint32_t a, uint32_t b) {
-    return a ^ b;
+    size_t pn = p->size();
+    size_t qn = q->size();
+    size_t rn = k == bit_kernel::and_n ? std::min(pn, qn) : k == bit_kernel::andn_n ? pn : std::max(pn, qn);
+    storage r(rn + 1, 0);
+    apply_bitwise(k, r.data(), p->data(), pn, q->data(), qn);
+    size_t low = 0;
+    if (p_neg) {
+        low = not_zero_id(*p) + 1;
+    }
+    if (q_neg) {
+        low = std::max(low, not_zero_id(*q) + 1);
+    }
+    low = std::min(low, rn);
+    if (low > 0) {
+        storage lp = low_words(*p, low, p_neg);
+        storage lq = low_words(*q, low, q_neg);
+        apply_bitwise(k, r.data(), lp.data(), low, lq.data(), low);
+    }
+    if (negative) {
+        uint32_t const one = 1;
+        limbs::add(r.data(), r.data(), rn + 1, &one, 1);
+    }
+    remove_zeroes(r);
+    return (*this = from_words(negative ? -1 : 1, std::move(r)));
 }
 
 big_integer& big_integer::operator&=(big_integer const& rhs) {
-    return bit_operation(rhs, bit_and);
+    return bit_operation(rhs, bit_op::and_op);
 }
 
 big_integer& big_integer::operator|=(big_integer const& rhs) {
-    return bit_operation(rhs, bit_or);
+    return bit_operation(rhs, bit_op::or_op);
 }
 
 big_integer& big_integer::operator^=(big_integer const& rhs) {
-    return bit_operation(rhs, bit_xor);
+    return bit_operation(rhs, bit_op::xor_op);
 }
 
 big_integer& big_integer::operator<<=(int rhs) {
     if (rhs < 0) {
         return *this >>= (-rhs);
     }
-    size_t big_shift = rhs / 32;
-    uint32_t small_shift = rhs % 32;
-    data.resize(big_shift + data.size(), 0);
-    if (small_shift == 0) {
+    if (sign == 0) {
         return *this;
     }
-    return (*this *= static_cast<uint32_t>(1ULL << small_shift));
+    size_t big_shift = rhs / 32;
+    uint32_t small_shift = rhs % 32;
+    size_t n = words.size();
+    storage value(n + big_shift + 1, 0);
+    value[n + big_shift] = limbs::lshift(value.data() + big_shift, words.data(), n, small_shift);
+    remove_zeroes(value);
+    words = std::move(value);
+    return *this;
 }
 
+// floor(x / 2^rhs): a negative x moves one further from zero when any shifted out bit is set
 big_integer& big_integer::operator>>=(int rhs) {
     if (rhs < 0) {
         return *this <<= (-rhs);
     }
     size_t big_shift = rhs / 32;
     uint32_t small_shift = rhs % 32;
-    if (big_shift >= data.size()) {
-        return (*this = 0);
+    if (big_shift >= words.size()) {
+        return (*this = (sign < 0 ? -1 : 0));
     }
-    size_t pos = not_zero_id(data);
-    data.resize(data.size() - big_shift);
-    data.insert(data.begin(), 0);
-    for (size_t i = 0; i < data.size(); ++i) {
-        data[i] = get_signed(data.size() - i - 1, pos);
+    size_t n = words.size() - big_shift;
+    storage value(n + 1, 0);
+    uint32_t out = limbs::rshift(value.data(), words.data() + big_shift, n, small_shift);
+    if (sign < 0 && (out != 0 || not_zero_id(words) < big_shift)) {
+        uint32_t const one = 1;
+        limbs::add(value.data(), value.data(), n + 1, &one, 1);
     }
-    uint64_t shifted = ((static_cast<int64_t>(data[0]) << 32LL) >> small_shift);
-    data[0] = shifted >> 32U;
-    shifted <<= 32U;
-    for (size_t i = 1; i < data.size(); ++i) {
-        shifted |= ((static_cast<uint64_t>(data[i]) << 32U) >> small_shift);
-        data[i] = shifted >> 32U;
-        shifted <<= 32U;
-    }
-    return (*this = get_value(data));
+    remove_zeroes(value);
+    return (*this = from_words(sign, std::move(value)));
 }
 
 big_integer big_integer::operator+() const {
     return *this;
 }
 
-big_integer big_integer::operator-() const {
-    return big_integer(-this->sign, this->data);
+big_integer big_integer::operator-() const& {
+    big_integer r(*this);
+    r.sign = -r.sign;
+    return r;
+}
+
+big_integer big_integer::operator-() && {
+    sign = -sign;
+    return std::move(*this);
 }
 
 big_integer big_integer::operator~() const {
@@ -450,47 +622,81 @@ big_integer big_integer::operator--(int) {
 }
 
 big_integer operator+(big_integer a, big_integer const& b) {
-    return a += b;
+    a += b;
+    return a;
+}
+
+big_integer operator+(big_integer const& a, big_integer&& b) {
+    return std::move(b += a);
 }
 
 big_integer operator-(big_integer a, big_integer const& b) {
-    return a -= b;
+    a -= b;
+    return a;
+}
+
+big_integer operator-(big_integer const& a, big_integer&& b) {
+    return -std::move(b -= a);
 }
 
 big_integer operator*(big_integer a, big_integer const& b) {
-    return a *= b;
+    a *= b;
+    return a;
+}
+
+big_integer operator*(big_integer const& a, big_integer&& b) {
+    return std::move(b *= a);
 }
 
 big_integer operator/(big_integer a, big_integer const& b) {
-    return a /= b;
+    a /= b;
+    return a;
 }
 
 big_integer operator%(big_integer a, big_integer const& b) {
-    return a %= b;
+    a %= b;
+    return a;
 }
 
 big_integer operator&(big_integer a, big_integer const& b) {
-    return a &= b;
+    a &= b;
+    return a;
+}
+
+big_integer operator&(big_integer const& a, big_integer&& b) {
+    return std::move(b &= a);
 }
 
 big_integer operator|(big_integer a, big_integer const& b) {
-    return a |= b;
+    a |= b;
+    return a;
+}
+
+big_integer operator|(big_integer const& a, big_integer&& b) {
+    return std::move(b |= a);
 }
 
 big_integer operator^(big_integer a, big_integer const& b) {
-    return a ^= b;
+    a ^= b;
+    return a;
+}
+
+big_integer operator^(big_integer const& a, big_integer&& b) {
+    return std::move(b ^= a);
 }
 
 big_integer operator<<(big_integer a, int b) {
-    return a <<= b;
+    a <<= b;
+    return a;
 }
 
 big_integer operator>>(big_integer a, int b) {
-    return a >>= b;
+    a >>= b;
+    return a;
 }
 
 bool operator==(big_integer const& a, big_integer const& b) {
-    return a.sign == b.sign && a.data == b.data;
+    return a.sign == b.sign && a.words == b.words;
 }
 
 bool operator!=(big_integer const& a, big_integer const& b) {
@@ -503,7 +709,7 @@ bool operator<(big_integer const& a, big_integer const& b) {
         if (sign == 0) {
             return false;
         }
-        return ((compare_abs(a.data, b.data) * sign) < 0);
+        return ((compare_abs(a.words, b.words) * sign) < 0);
     }
     return a.sign < b.sign;
 }
@@ -520,36 +726,299 @@ bool operator>=(big_integer const& a, big_integer const& b) {
     return !(a < b);
 }
 
+namespace {
+    struct string_sink {
+        void operator()(char const* digits, size_t count) {
+            out.append(digits, count);
+        }
+
+        std::string& out;
+    };
+}
+
+template <typename Sink>
+void big_integer::emit_decimal(big_integer const& x, size_t width, Sink& sink) {
+    static char const zeroes[] = "0000000000000000000000000000000000000000000000000000000000000000";
+    if (x.size() <= TO_STRING_THRESHOLD) {
+        uint32_t chunks[MAX_BASECASE_CHUNKS];
+        size_t count = 0;
+        uint32_t rest[TO_STRING_THRESHOLD];
+        size_t n = x.size();
+        std::copy(x.words.begin(), x.words.end(), rest);
+        while (n > 0) {
+            chunks[count++] = limbs::divrem_1(rest, rest, n, DECIMAL_BASE);
+            while (n > 0 && rest[n - 1] == 0) {
+                --n;
+            }
+        }
+        char buffer[MAX_BASECASE_CHUNKS * DECIMAL_DIGITS];
+        size_t len = count * DECIMAL_DIGITS;
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t chunk = chunks[i];
+            for (size_t k = 0; k < DECIMAL_DIGITS; ++k) {
+                buffer[len - i * DECIMAL_DIGITS - k - 1] = static_cast<char>('0' + chunk % 10);
+                chunk /= 10;
+            }
+        }
+        char const* begin = buffer;
+        if (width == 0) {
+            while (begin + 1 < buffer + len && *begin == '0') {
+                ++begin;
+            }
+        } else if (len > width) {
+            begin += len - width;
+        } else {
+            for (size_t pad = width - len; pad > 0;) {
+                size_t step = std::min(pad, sizeof(zeroes) - 1);
+                sink(zeroes, step);
+                pad -= step;
+            }
+        }
+        sink(begin, buffer + len - begin);
+        return;
+    }
+    size_t level = 0;
+    while (decimal_power(level + 1).size() * 2 <= x.size()) {
+        ++level;
+    }
+    std::pair<big_integer, big_integer> qr = divmod(x, decimal_power(level));
+    size_t low_width = DECIMAL_DIGITS << level;
+    if (x.size() >= PARALLEL_CONVERSION_THRESHOLD && low_width <= PARALLEL_BUFFER_DIGITS && parallel::threads() > 1) {
+        // the low digits are buffered while the high ones go out
+        std::string low;
+        low.reserve(low_width);
+        string_sink low_sink{low};
+        parallel::invoke([&] { emit_decimal(qr.first, width == 0 ? 0 : width - low_width, sink); },
+                         [&] { emit_decimal(qr.second, low_width, low_sink); });
+        sink(low.data(), low.size());
+        return;
+    }
+    emit_decimal(qr.first, width == 0 ? 0 : width - low_width, sink);
+    emit_decimal(qr.second, low_width, sink);
+}
+
 std::string to_string(big_integer const& a) {
-    std::string result;
     if (a.sign == 0) {
         return "0";
     }
-    big_integer s(a);
-    s.sign = 1;
-    while (s > 0) {
-        big_integer temp(s % 10);
-        if (temp == 0) {
-            result.push_back('0');
-        } else {
-            result.push_back(temp.data[0] + '0');
-        }
-        s /= 10;
-    }
-    if (a.sign == -1) {
+    std::string result;
+    result.reserve(a.size() * 10 + 1);
+    if (a.sign < 0) {
         result.push_back('-');
     }
-    reverse(result.begin(), result.end());
+    auto append = [&result](char const* digits, size_t count) {
+        result.append(digits, count);
+    };
+    big_integer::emit_decimal(a, 0, append);
     return result;
 }
 
 big_integer &big_integer::operator=(big_integer const &other) {
-    big_integer tmp(other);
-    data.swap(tmp.data);
-    std::swap(sign, tmp.sign);
+    words = other.words;
+    sign = other.sign;
+    return *this;
+}
+
+big_integer &big_integer::operator=(big_integer &&other) noexcept {
+    if (this != &other) {
+        words = std::move(other.words);
+        sign = other.sign;
+        other.words.clear();
+        other.sign = 0;
+    }
     return *this;
 }
 
+namespace {
+    // Collects digits into a fixed buffer and hands them to the caller's sink in pieces.
+    struct buffered_sink {
+        explicit buffered_sink(digit_sink const& out) : out(out) {}
+
+        ~buffered_sink() {
+            flush();
+        }
+
+        void operator()(char const* digits, size_t count) {
+            if (used + count > sizeof(buffer)) {
+                flush();
+            }
+            if (count >= sizeof(buffer)) {
+                out(digits, count);
+                return;
+            }
+            std::copy(digits, digits + count, buffer + used);
+            used += count;
+        }
+
+        void flush() {
+            if (used != 0) {
+                out(buffer, used);
+                used = 0;
+            }
+        }
+
+    private:
+        digit_sink const& out;
+        char buffer[4096];
+        size_t used = 0;
+    };
+}
+
+void write_decimal(big_integer const& a, digit_sink const& sink) {
+    buffered_sink out(sink);
+    if (a.sign == 0) {
+        out("0", 1);
+        return;
+    }
+    if (a.sign < 0) {
+        out("-", 1);
+    }
+    big_integer::emit_decimal(a, 0, out);
+}
+
+void write_radix(big_integer const& a, int radix, digit_sink const& sink) {
+    uint32_t bits = radix_bits(radix);
+    if (bits == 0) {
+        write_decimal(a, sink);
+        return;
+    }
+    if (a.sign == 0) {
+        sink("0", 1);
+        return;
+    }
+    char buffer[4096];
+    size_t used = 0;
+    if (a.sign < 0) {
+        buffer[used++] = '-';
+    }
+    size_t n = a.size();
+    size_t bit_length = 32 * n - __builtin_clz(a.words[n - 1]);
+    uint32_t mask = (1U << bits) - 1;
+    for (size_t i = (bit_length + bits - 1) / bits; i > 0; --i) {
+        size_t pos = (i - 1) * bits;
+        size_t offset = pos % 32;
+        uint32_t value = a.words[pos / 32] >> offset;
+        if (offset + bits > 32 && pos / 32 + 1 < n) {
+            value |= a.words[pos / 32 + 1] << (32 - offset);
+        }
+        buffer[used++] = RADIX_DIGITS[value & mask];
+        if (used == sizeof(buffer)) {
+            sink(buffer, used);
+            used = 0;
+        }
+    }
+    if (used != 0) {
+        sink(buffer, used);
+    }
+}
+
+void write_hex(big_integer const& a, digit_sink const& sink) {
+    write_radix(a, 16, sink);
+}
+
+std::string to_string(big_integer const& a, int radix) {
+    if (radix == 10) {
+        return to_string(a);
+    }
+    std::string result;
+    result.reserve(a.size() * 32 / radix_bits(radix) + 2);
+    write_radix(a, radix, [&result](char const* digits, size_t count) {
+        result.append(digits, count);
+    });
+    return result;
+}
+
+// offset in an import/export buffer of byte k of the magnitude, counting from the least significant
+static size_t byte_offset(size_t k, size_t count, size_t word_size, endian order, endian byte_order) {
+    size_t word = k / word_size;
+    size_t byte = k % word_size;
+    if (order == endian::big) {
+        word = count - 1 - word;
+    }
+    if (byte_order == endian::big) {
+        byte = word_size - 1 - byte;
+    }
+    return word * word_size + byte;
+}
+
+static bool is_native_little(endian order, endian byte_order) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return order == endian::little && byte_order == endian::little;
+#else
+    (void) order;
+    (void) byte_order;
+    return false;
+#endif
+}
+
+big_integer import_bytes(void const* data, size_t count, size_t word_size, endian order, endian byte_order) {
+    if (word_size == 0) {
+        throw std::runtime_error("Invalid word size");
+    }
+    auto bytes = static_cast<unsigned char const*>(data);
+    size_t total = count * word_size;
+    storage res((total + 3) / 4, 0);
+    if (is_native_little(order, byte_order)) {
+        std::copy(bytes, bytes + total, reinterpret_cast<unsigned char*>(res.data()));
+    } else {
+        for (size_t k = 0; k < total; ++k) {
+            res[k / 4] |= static_cast<uint32_t>(bytes[byte_offset(k, count, word_size, order, byte_order)]) << (8 * (k % 4));
+        }
+    }
+    while (!res.empty() && res.back() == 0) {
+        res.pop_back();
+    }
+    return big_integer::from_words(1, std::move(res));
+}
+
+size_t export_size(big_integer const& a, size_t word_size) {
+    if (word_size == 0) {
+        throw std::runtime_error("Invalid word size");
+    }
+    if (a.sign == 0) {
+        return 0;
+    }
+    size_t n = a.size();
+    size_t byte_length = 4 * n - __builtin_clz(a.words[n - 1]) / 8;
+    return (byte_length + word_size - 1) / word_size;
+}
+
+size_t export_bytes(void* out, big_integer const& a, size_t word_size, endian order, endian byte_order) {
+    size_t count = export_size(a, word_size);
+    auto bytes = static_cast<unsigned char*>(out);
+    size_t total = count * word_size;
+    size_t available = a.size() * 4;
+    if (is_native_little(order, byte_order)) {
+        size_t copied = std::min(total, available);
+        auto words = reinterpret_cast<unsigned char const*>(a.words.data());
+        std::copy(words, words + copied, bytes);
+        std::fill(bytes + copied, bytes + total, 0);
+    } else {
+        for (size_t k = 0; k < total; ++k) {
+            unsigned char byte = k < available ? static_cast<unsigned char>(a.words[k / 4] >> (8 * (k % 4))) : 0;
+            bytes[byte_offset(k, count, word_size, order, byte_order)] = byte;
+        }
+    }
+    return count;
+}
+
+std::vector<unsigned char> export_bytes(big_integer const& a, size_t word_size, endian order, endian byte_order) {
+    std::vector<unsigned char> res(export_size(a, word_size) * word_size);
+    export_bytes(res.data(), a, word_size, order, byte_order);
+    return res;
+}
+
 std::ostream& operator<<(std::ostream& s, big_integer const& a) {
-    return s << to_string(a);
+    auto write = [&s](char const* digits, size_t count) {
+        s.write(digits, static_cast<std::streamsize>(count));
+    };
+    std::ios_base::fmtflags base = s.flags() & std::ios_base::basefield;
+    if (base == std::ios_base::hex) {
+        write_radix(a, 16, write);
+    } else if (base == std::ios_base::oct) {
+        write_radix(a, 8, write);
+    } else {
+        write_decimal(a, write);
+    }
+    return s;
 }
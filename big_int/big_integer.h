@@ -3,26 +3,60 @@
 
 #include <cstddef>
 #include <iosfwd>
+#include <iterator>
+#include <string>
 #include <cstdint>
 #include <vector>
 #include <functional>
+#include <tuple>
+#include <utility>
+
+#include "storage.h"
+
+// Word order and byte order of the buffers taken by import_bytes and export_bytes.
+enum class endian { little, big };
+
+// Magnitude words of a big_integer, most significant first, read in place: valid until the
+// value is next modified. Converting to a vector makes a copy that outlives it.
+struct magnitude_view {
+    using const_iterator = std::reverse_iterator<uint32_t const*>;
+
+    magnitude_view(uint32_t const* words, size_t count); // O(1) nothrow
+
+    const_iterator begin() const;                       // O(1) nothrow
+    const_iterator end() const;                         // O(1) nothrow
+    size_t size() const;                                // O(1) nothrow
+    bool empty() const;                                 // O(1) nothrow
+    uint32_t operator[](size_t i) const;                // O(1) nothrow
+
+    operator std::vector<uint32_t>() const;             // O(N) strong
+
+private:
+    uint32_t const* words;
+    size_t count;
+};
 
 struct big_integer {
     big_integer();
     big_integer(big_integer const& other);
+    big_integer(big_integer&& other) noexcept;
     big_integer(int a);
     big_integer(uint32_t a);
     explicit big_integer(std::string const& str);
-    big_integer(int32_t sign, std::vector<uint32_t> const& words);
+    // radix is 10 or a power of two up to 32; digits past 9 are letters in either case
+    big_integer(std::string const& str, int radix);
+    // magnitude words are given most significant first, as returned by data()
+    big_integer(int32_t sign, std::vector<uint32_t> const& magnitude);
     explicit big_integer(std::vector<uint32_t> const& other);
 
     ~big_integer() = default;
 
     big_integer& operator=(big_integer const& other);
+    big_integer& operator=(big_integer&& other) noexcept;
     big_integer& operator+=(big_integer const& rhs);
     big_integer& operator-=(big_integer const& rhs);
     big_integer& operator*=(big_integer const& rhs);
-    big_integer& operator/=(big_integer const& other);
+    big_integer& operator/=(big_integer const& rhs);
     big_integer& operator%=(big_integer const& rhs);
 
     big_integer& operator&=(big_integer const& rhs);
@@ -33,7 +67,8 @@ struct big_integer {
     big_integer& operator>>=(int rhs);
 
     big_integer operator+() const;
-    big_integer operator-() const;
+    big_integer operator-() const&;
+    big_integer operator-() &&;
     big_integer operator~() const;
 
     big_integer& operator++();
@@ -49,40 +84,82 @@ struct big_integer {
     friend bool operator<=(big_integer const& a, big_integer const& b);
     friend bool operator>=(big_integer const& a, big_integer const& b);
 
+    friend std::pair<big_integer, big_integer> divmod(big_integer const& a, big_integer const& b);
+    friend void addmul(big_integer& r, big_integer const& a, big_integer const& b);
+    friend void submul(big_integer& r, big_integer const& a, big_integer const& b);
+
+    friend struct modulus_context;
+    friend struct divisor;
+    friend struct batch;
+    friend big_integer gcd(big_integer const& a, big_integer const& b);
+    friend std::tuple<big_integer, big_integer, big_integer> gcdext(big_integer const& a, big_integer const& b);
+    friend big_integer isqrt(big_integer const& n);
+    friend big_integer iroot(big_integer const& n, int k);
+    friend bool is_square(big_integer const& n);
+    friend bool is_perfect_power(big_integer const& n);
+    friend big_integer sum(std::vector<big_integer> const& terms);
+
     friend std::string to_string(big_integer const& a);
+    friend std::string to_string(big_integer const& a, int radix);
+    friend void write_decimal(big_integer const& a, std::function<void(char const*, size_t)> const& sink);
+    friend void write_radix(big_integer const& a, int radix, std::function<void(char const*, size_t)> const& sink);
+
+    friend big_integer import_bytes(void const* data, size_t count, size_t word_size, endian order, endian byte_order);
+    friend size_t export_size(big_integer const& a, size_t word_size);
+    friend size_t export_bytes(void* out, big_integer const& a, size_t word_size, endian order, endian byte_order);
 
-    std::vector<uint32_t> data;
+    // magnitude words, most significant first, without copying them
+    magnitude_view data() const;
 private:
+    // magnitude, least significant word first, without high zero words
+    storage words;
     int32_t sign;
 
-    big_integer& add_signed(int32_t rhs_sign, std::vector<uint32_t> const& rhs_words);
+    static big_integer from_words(int32_t sign, storage&& words);
 
-    uint32_t get_signed(size_t id, size_t not_zero_pos) const;
+    static big_integer from_chunks(uint32_t const* chunks, size_t count);
 
-    static bool smaller(const big_integer &a, const big_integer &b, size_t index);
-
-    size_t size() const;
+    // decimal digits of |x|, zero-padded to width unless width is 0
+    template <typename Sink>
+    static void emit_decimal(big_integer const& x, size_t width, Sink& sink);
 
-    static void difference(big_integer &a, const big_integer &b, size_t index);
+    big_integer& add_signed(int32_t rhs_sign, storage const& rhs_words);
+    // *this += product_sign * |a| * |b|
+    big_integer& add_product(int32_t product_sign, big_integer const& a, big_integer const& b);
 
-    static big_integer shortdiv(const big_integer &lhs, uint32_t rhs);
+    size_t size() const;
 
-    big_integer &bit_operation(const big_integer &rhs, const std::function<uint32_t(uint32_t, uint32_t)>& op);
+    enum class bit_op { and_op, or_op, xor_op };
+    big_integer& bit_operation(big_integer const& rhs, bit_op op);
 };
 
 big_integer operator+(big_integer a, big_integer const& b);
+big_integer operator+(big_integer const& a, big_integer&& b);
 big_integer operator-(big_integer a, big_integer const& b);
+big_integer operator-(big_integer const& a, big_integer&& b);
 big_integer operator*(big_integer a, big_integer const& b);
+big_integer operator*(big_integer const& a, big_integer&& b);
 big_integer operator/(big_integer a, big_integer const& b);
 big_integer operator%(big_integer a, big_integer const& b);
 
 big_integer operator&(big_integer a, big_integer const& b);
+big_integer operator&(big_integer const& a, big_integer&& b);
 big_integer operator|(big_integer a, big_integer const& b);
+big_integer operator|(big_integer const& a, big_integer&& b);
 big_integer operator^(big_integer a, big_integer const& b);
+big_integer operator^(big_integer const& a, big_integer&& b);
 
 big_integer operator<<(big_integer a, int b);
 big_integer operator>>(big_integer a, int b);
 
+// r += a * b and r -= a * b without a temporary for the product: below the Karatsuba threshold
+// its rows are accumulated straight into the limbs of r, so x = c; addmul(x, a, b) computes a * b + c
+void addmul(big_integer& r, big_integer const& a, big_integer const& b);
+void submul(big_integer& r, big_integer const& a, big_integer const& b);
+
+// quotient truncated toward zero and remainder with the sign of a, from a single division
+std::pair<big_integer, big_integer> divmod(big_integer const& a, big_integer const& b);
+
 bool operator==(big_integer const& a, big_integer const& b);
 bool operator!=(big_integer const& a, big_integer const& b);
 bool operator<(big_integer const& a, big_integer const& b);
@@ -91,6 +168,26 @@ bool operator<=(big_integer const& a, big_integer const& b);
 bool operator>=(big_integer const& a, big_integer const& b);
 
 std::string to_string(big_integer const& a);
+// radix is 10 or a power of two up to 32, lower-case digits
+std::string to_string(big_integer const& a, int radix);
+// honours std::hex and std::oct, decimal otherwise
 std::ostream& operator<<(std::ostream& s, big_integer const& a);
 
+// Streams the digits of a, most significant first, to sink in pieces of bounded size.
+// Decimal output starts as soon as the top-level split is computed; hex output needs no extra memory.
+using digit_sink = std::function<void(char const*, size_t)>;
+void write_decimal(big_integer const& a, digit_sink const& sink);
+void write_hex(big_integer const& a, digit_sink const& sink);
+// power-of-two radices take one linear pass over the words
+void write_radix(big_integer const& a, int radix, digit_sink const& sink);
+
+// Raw magnitude transfer in the manner of mpz_import/mpz_export: count words of word_size bytes,
+// order telling which word comes first and byte_order how bytes sit inside a word. The sign is not stored.
+big_integer import_bytes(void const* data, size_t count, size_t word_size, endian order, endian byte_order);
+// number of words export_bytes writes for a, 0 for zero
+size_t export_size(big_integer const& a, size_t word_size);
+// out must have room for export_size(a, word_size) words; returns that count
+size_t export_bytes(void* out, big_integer const& a, size_t word_size, endian order, endian byte_order);
+std::vector<unsigned char> export_bytes(big_integer const& a, size_t word_size, endian order, endian byte_order);
+
 #endif // BIG_INTEGER_H
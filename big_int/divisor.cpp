@@ -0,0 +1,53 @@
+#include "divisor.h"
+#include "limbs.h"
+
+#include <stdexcept>
+
+divisor::divisor(big_integer const& d) : d(d), norm(d.words.begin(), d.words.end()), shift(0), inv(0) {
+    if (d.sign == 0) {
+        throw std::runtime_error("Division by zero");
+    }
+    size_t n = norm.size();
+    shift = __builtin_clz(norm[n - 1]);
+    limbs::lshift(norm.data(), norm.data(), n, shift);
+    inv = n == 1 ? limbs::invert_1(norm[0]) : limbs::invert_2(norm[n - 1], norm[n - 2]);
+}
+
+big_integer const& divisor::value() const {
+    return d;
+}
+
+big_integer divisor::from_limbs(int32_t sign, storage&& a) {
+    while (!a.empty() && a.back() == 0) {
+        a.pop_back();
+    }
+    return big_integer::from_words(sign, std::move(a));
+}
+
+std::pair<big_integer, big_integer> divisor::divide(big_integer const& a) const {
+    size_t an = a.words.size();
+    size_t dn = norm.size();
+    if (an < dn || (an == dn && limbs::cmp(a.words.data(), d.words.data(), an) < 0)) {
+        return {0, a};
+    }
+    storage q(an - dn + 1, 0);
+    storage r(dn, 0);
+    if (dn == 1) {
+        r[0] = limbs::divrem_1_preinv(q.data(), a.words.data(), an, norm[0], shift, inv);
+    } else {
+        limbs::divrem_preinv(q.data(), r.data(), a.words.data(), an, norm.data(), dn, shift, inv);
+    }
+    return {from_limbs(a.sign * d.sign, std::move(q)), from_limbs(a.sign, std::move(r))};
+}
+
+std::pair<big_integer, big_integer> divmod(big_integer const& a, divisor const& d) {
+    return d.divide(a);
+}
+
+big_integer operator/(big_integer const& a, divisor const& d) {
+    return divmod(a, d).first;
+}
+
+big_integer operator%(big_integer const& a, divisor const& d) {
+    return divmod(a, d).second;
+}
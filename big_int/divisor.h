@@ -0,0 +1,37 @@
+#ifndef DIVISOR_H
+#define DIVISOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "big_integer.h"
+
+// Precomputed data for repeated division by a fixed d != 0: the divisor is normalized once and
+// its Moller-Granlund reciprocal stored, so every quotient limb costs multiplications, not a divide.
+struct divisor {
+    explicit divisor(big_integer const& d);
+
+    big_integer const& value() const;
+
+    // same results as a / d and a % d: the quotient truncates, the remainder has the sign of a
+    friend std::pair<big_integer, big_integer> divmod(big_integer const& a, divisor const& d);
+
+private:
+    std::pair<big_integer, big_integer> divide(big_integer const& a) const;
+
+    static big_integer from_limbs(int32_t sign, storage&& a);
+
+    big_integer d;
+    // d shifted left by shift bits so that its top bit is set
+    std::vector<uint32_t> norm;
+    uint32_t shift;
+    // invert_1 or invert_2 of the top limbs of norm
+    uint32_t inv;
+};
+
+big_integer operator/(big_integer const& a, divisor const& d);
+big_integer operator%(big_integer const& a, divisor const& d);
+
+#endif // DIVISOR_H
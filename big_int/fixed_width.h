@@ -0,0 +1,590 @@
+#ifndef FIXED_WIDTH_H
+#define FIXED_WIDTH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "big_integer.h"
+
+// Fixed-width integers of Bits bits (a multiple of 32) on a std::array of limbs, least significant
+// first. Everything but the string and big_integer conversions is constexpr; the loops have
+// compile-time bounds, so the compiler unrolls them and nothing touches the heap.
+// big_uint wraps modulo 2^Bits; big_int is two's complement over the same limbs, its division
+// truncates toward zero and >> shifts in copies of the sign bit, like big_integer.
+
+namespace fixed_limbs {
+    template <size_t N>
+    using limbs_t = std::array<uint32_t, N>;
+
+    template <size_t N>
+    constexpr uint32_t add(limbs_t<N>& r, limbs_t<N> const& a, limbs_t<N> const& b) {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < N; ++i) {
+            carry += static_cast<uint64_t>(a[i]) + b[i];
+            r[i] = static_cast<uint32_t>(carry);
+            carry >>= 32U;
+        }
+        return static_cast<uint32_t>(carry);
+    }
+
+    template <size_t N>
+    constexpr uint32_t sub(limbs_t<N>& r, limbs_t<N> const& a, limbs_t<N> const& b) {
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < N; ++i) {
+            uint64_t d = static_cast<uint64_t>(a[i]) - b[i] - borrow;
+            r[i] = static_cast<uint32_t>(d);
+            borrow = d >> 63U;
+        }
+        return static_cast<uint32_t>(borrow);
+    }
+
+    // the low N limbs of a * b
+    template <size_t N>
+    constexpr limbs_t<N> mul(limbs_t<N> const& a, limbs_t<N> const& b) {
+        limbs_t<N> r{};
+        for (size_t i = 0; i < N; ++i) {
+            uint64_t carry = 0;
+            for (size_t j = 0; i + j < N; ++j) {
+                carry += static_cast<uint64_t>(a[i]) * b[j] + r[i + j];
+                r[i + j] = static_cast<uint32_t>(carry);
+                carry >>= 32U;
+            }
+        }
+        return r;
+    }
+
+    template <size_t N>
+    constexpr int32_t cmp(limbs_t<N> const& a, limbs_t<N> const& b) {
+        for (size_t i = N; i > 0; --i) {
+            if (a[i - 1] != b[i - 1]) {
+                return a[i - 1] < b[i - 1] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    // number of limbs up to the highest nonzero one
+    template <size_t N>
+    constexpr size_t size(limbs_t<N> const& a) {
+        size_t n = N;
+        while (n > 0 && a[n - 1] == 0) {
+            --n;
+        }
+        return n;
+    }
+
+    constexpr uint32_t leading_zeros(uint32_t x) {
+        uint32_t n = 0;
+        for (uint32_t bit = 0x80000000U; bit != 0 && (x & bit) == 0; bit >>= 1U) {
+            ++n;
+        }
+        return n;
+    }
+
+    // a << bits and a >> bits, the vacated limbs filled with fill
+    template <size_t N>
+    constexpr limbs_t<N> shift_left(limbs_t<N> const& a, size_t bits) {
+        limbs_t<N> r{};
+        size_t s = bits / 32;
+        uint32_t b = bits % 32;
+        for (size_t i = N; i > s; --i) {
+            size_t k = i - 1 - s;
+            r[i - 1] = a[k] << b;
+            if (b != 0 && k > 0) {
+                r[i - 1] |= a[k - 1] >> (32U - b);
+            }
+        }
+        return r;
+    }
+
+    template <size_t N>
+    constexpr limbs_t<N> shift_right(limbs_t<N> const& a, size_t bits, uint32_t fill) {
+        limbs_t<N> r{};
+        size_t s = bits / 32;
+        uint32_t b = bits % 32;
+        for (size_t i = 0; i < N; ++i) {
+            uint32_t lo = i + s < N ? a[i + s] : fill;
+            uint32_t hi = i + s + 1 < N ? a[i + s + 1] : fill;
+            r[i] = b == 0 ? lo : (lo >> b) | (hi << (32U - b));
+        }
+        return r;
+    }
+
+    // |count| of a shift, INT_MIN included
+    constexpr size_t shift_count(int count) {
+        return count < 0 ? size_t(0) - static_cast<size_t>(count) : static_cast<size_t>(count);
+    }
+
+    // q = a / b and r = a % b (Knuth, Algorithm D); a and b are taken by value so q or r may be either
+    template <size_t N>
+    constexpr void divmod(limbs_t<N> a, limbs_t<N> b, limbs_t<N>& q, limbs_t<N>& r) {
+        size_t n = size(b);
+        if (n == 0) {
+            throw std::runtime_error("Division by zero");
+        }
+        q = limbs_t<N>{};
+        r = limbs_t<N>{};
+        size_t m = size(a);
+        if (m < n) {
+            r = a;
+            return;
+        }
+        if (n == 1) {
+            uint64_t rem = 0;
+            for (size_t i = m; i > 0; --i) {
+                uint64_t cur = (rem << 32U) | a[i - 1];
+                q[i - 1] = static_cast<uint32_t>(cur / b[0]);
+                rem = cur % b[0];
+            }
+            r[0] = static_cast<uint32_t>(rem);
+            return;
+        }
+        // normalize so that the top limb of v has its high bit set
+        uint32_t s = leading_zeros(b[n - 1]);
+        limbs_t<N> v = shift_left(b, s);
+        limbs_t<N + 1> u{};
+        for (size_t i = 0; i < N; ++i) {
+            u[i] = a[i] << s;
+            if (s != 0 && i > 0) {
+                u[i] |= a[i - 1] >> (32U - s);
+            }
+        }
+        u[N] = s == 0 ? 0 : a[N - 1] >> (32U - s);
+        uint64_t const base = uint64_t(1) << 32U;
+        for (size_t j = m - n + 1; j > 0; --j) {
+            size_t k = j - 1;
+            uint64_t top = (static_cast<uint64_t>(u[k + n]) << 32U) | u[k + n - 1];
+            uint64_t qhat = top / v[n - 1];
+            uint64_t rhat = top % v[n - 1];
+            while (qhat >= base || qhat * v[n - 2] > ((rhat << 32U) | u[k + n - 2])) {
+                --qhat;
+                rhat += v[n - 1];
+                if (rhat >= base) {
+                    break;
+                }
+            }
+            int64_t borrow = 0;
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t p = qhat * v[i];
+                int64_t t = static_cast<int64_t>(u[i + k]) - borrow - static_cast<int64_t>(p & 0xffffffffU);
+                u[i + k] = static_cast<uint32_t>(t);
+                borrow = static_cast<int64_t>(p >> 32U) - (t >> 32);
+            }
+            int64_t t = static_cast<int64_t>(u[k + n]) - borrow;
+            u[k + n] = static_cast<uint32_t>(t);
+            q[k] = static_cast<uint32_t>(qhat);
+            if (t < 0) {
+                // qhat was one too large: add v back
+                --q[k];
+                uint64_t carry = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    carry += static_cast<uint64_t>(u[i + k]) + v[i];
+                    u[i + k] = static_cast<uint32_t>(carry);
+                    carry >>= 32U;
+                }
+                u[k + n] += static_cast<uint32_t>(carry);
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            r[i] = u[i] >> s;
+            if (s != 0) {
+                r[i] |= u[i + 1] << (32U - s);
+            }
+        }
+    }
+
+    // two's complement of a, in place
+    template <size_t N>
+    constexpr void negate(limbs_t<N>& a) {
+        uint64_t carry = 1;
+        for (size_t i = 0; i < N; ++i) {
+            carry += static_cast<uint32_t>(~a[i]);
+            a[i] = static_cast<uint32_t>(carry);
+            carry >>= 32U;
+        }
+    }
+
+    // a modulo 2^(32 N), two's complement for negative a
+    template <size_t N>
+    limbs_t<N> from_big_integer(big_integer const& a) {
+        limbs_t<N> r{};
+        magnitude_view magnitude = a.data();
+        for (size_t i = 0; i < N && i < magnitude.size(); ++i) {
+            r[i] = magnitude[magnitude.size() - 1 - i];
+        }
+        if (a < 0) {
+            negate(r);
+        }
+        return r;
+    }
+
+    template <size_t N>
+    big_integer to_big_integer(limbs_t<N> const& a, bool negative) {
+        limbs_t<N> m = a;
+        if (negative) {
+            negate(m);
+        }
+        size_t n = size(m);
+        if (n == 0) {
+            return big_integer();
+        }
+        std::vector<uint32_t> magnitude(n);
+        for (size_t i = 0; i < n; ++i) {
+            magnitude[i] = m[n - 1 - i];
+        }
+        return big_integer(negative ? -1 : 1, magnitude);
+    }
+}
+
+template <size_t Bits>
+struct big_uint {
+    static_assert(Bits > 0 && Bits % 32 == 0, "Bits must be a positive multiple of 32");
+    static constexpr size_t LIMBS = Bits / 32;
+    using limbs_t = fixed_limbs::limbs_t<LIMBS>;
+
+    constexpr big_uint() : limbs_{} {}
+    // negative values wrap modulo 2^Bits
+    template <typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    constexpr big_uint(T a) : limbs_{} {
+        uint64_t v = static_cast<uint64_t>(a);
+        uint32_t fill = std::is_signed<T>::value && static_cast<int64_t>(v) < 0 ? UINT32_MAX : 0;
+        for (size_t i = 0; i < LIMBS; ++i) {
+            limbs_[i] = i == 0 ? static_cast<uint32_t>(v) : i == 1 ? static_cast<uint32_t>(v >> 32U) : fill;
+        }
+    }
+    constexpr explicit big_uint(limbs_t const& limbs) : limbs_(limbs) {}
+    // modulo 2^Bits
+    explicit big_uint(big_integer const& a) : limbs_(fixed_limbs::from_big_integer<LIMBS>(a)) {}
+    explicit big_uint(std::string const& str) : big_uint(big_integer(str)) {}
+
+    explicit operator big_integer() const {
+        return fixed_limbs::to_big_integer(limbs_, false);
+    }
+    constexpr explicit operator bool() const {
+        return fixed_limbs::size(limbs_) != 0;
+    }
+
+    constexpr limbs_t const& limbs() const {
+        return limbs_;
+    }
+
+    constexpr big_uint& operator+=(big_uint const& rhs) {
+        fixed_limbs::add(limbs_, limbs_, rhs.limbs_);
+        return *this;
+    }
+    constexpr big_uint& operator-=(big_uint const& rhs) {
+        fixed_limbs::sub(limbs_, limbs_, rhs.limbs_);
+        return *this;
+    }
+    constexpr big_uint& operator*=(big_uint const& rhs) {
+        limbs_ = fixed_limbs::mul(limbs_, rhs.limbs_);
+        return *this;
+    }
+    constexpr big_uint& operator/=(big_uint const& rhs) {
+        limbs_t r{};
+        fixed_limbs::divmod(limbs_, rhs.limbs_, limbs_, r);
+        return *this;
+    }
+    constexpr big_uint& operator%=(big_uint const& rhs) {
+        limbs_t q{};
+        fixed_limbs::divmod(limbs_, rhs.limbs_, q, limbs_);
+        return *this;
+    }
+
+    constexpr big_uint& operator&=(big_uint const& rhs) {
+        for (size_t i = 0; i < LIMBS; ++i) {
+            limbs_[i] &= rhs.limbs_[i];
+        }
+        return *this;
+    }
+    constexpr big_uint& operator|=(big_uint const& rhs) {
+        for (size_t i = 0; i < LIMBS; ++i) {
+            limbs_[i] |= rhs.limbs_[i];
+        }
+        return *this;
+    }
+    constexpr big_uint& operator^=(big_uint const& rhs) {
+        for (size_t i = 0; i < LIMBS; ++i) {
+            limbs_[i] ^= rhs.limbs_[i];
+        }
+        return *this;
+    }
+
+    // shifts by Bits or more leave 0; a negative count shifts the other way
+    constexpr big_uint& operator<<=(int rhs) {
+        size_t count = fixed_limbs::shift_count(rhs);
+        limbs_ = rhs < 0 ? fixed_limbs::shift_right(limbs_, count, 0) : fixed_limbs::shift_left(limbs_, count);
+        return *this;
+    }
+    constexpr big_uint& operator>>=(int rhs) {
+        size_t count = fixed_limbs::shift_count(rhs);
+        limbs_ = rhs < 0 ? fixed_limbs::shift_left(limbs_, count) : fixed_limbs::shift_right(limbs_, count, 0);
+        return *this;
+    }
+
+    constexpr big_uint operator+() const {
+        return *this;
+    }
+    constexpr big_uint operator-() const {
+        big_uint res = *this;
+        fixed_limbs::negate(res.limbs_);
+        return res;
+    }
+    constexpr big_uint operator~() const {
+        big_uint res = *this;
+        for (uint32_t& x : res.limbs_) {
+            x = ~x;
+        }
+        return res;
+    }
+
+    constexpr big_uint& operator++() {
+        return *this += 1;
+    }
+    constexpr big_uint operator++(int) {
+        big_uint res = *this;
+        ++*this;
+        return res;
+    }
+    constexpr big_uint& operator--() {
+        return *this -= 1;
+    }
+    constexpr big_uint operator--(int) {
+        big_uint res = *this;
+        --*this;
+        return res;
+    }
+
+    friend constexpr big_uint operator+(big_uint a, big_uint const& b) { return a += b; }
+    friend constexpr big_uint operator-(big_uint a, big_uint const& b) { return a -= b; }
+    friend constexpr big_uint operator*(big_uint a, big_uint const& b) { return a *= b; }
+    friend constexpr big_uint operator/(big_uint a, big_uint const& b) { return a /= b; }
+    friend constexpr big_uint operator%(big_uint a, big_uint const& b) { return a %= b; }
+    friend constexpr big_uint operator&(big_uint a, big_uint const& b) { return a &= b; }
+    friend constexpr big_uint operator|(big_uint a, big_uint const& b) { return a |= b; }
+    friend constexpr big_uint operator^(big_uint a, big_uint const& b) { return a ^= b; }
+    friend constexpr big_uint operator<<(big_uint a, int b) { return a <<= b; }
+    friend constexpr big_uint operator>>(big_uint a, int b) { return a >>= b; }
+
+    friend constexpr bool operator==(big_uint const& a, big_uint const& b) {
+        return fixed_limbs::cmp(a.limbs_, b.limbs_) == 0;
+    }
+    friend constexpr bool operator!=(big_uint const& a, big_uint const& b) {
+        return !(a == b);
+    }
+    friend constexpr bool operator<(big_uint const& a, big_uint const& b) {
+        return fixed_limbs::cmp(a.limbs_, b.limbs_) < 0;
+    }
+    friend constexpr bool operator>(big_uint const& a, big_uint const& b) {
+        return b < a;
+    }
+    friend constexpr bool operator<=(big_uint const& a, big_uint const& b) {
+        return !(b < a);
+    }
+    friend constexpr bool operator>=(big_uint const& a, big_uint const& b) {
+        return !(a < b);
+    }
+
+private:
+    limbs_t limbs_;
+};
+
+template <size_t Bits>
+struct big_int {
+    static constexpr size_t LIMBS = big_uint<Bits>::LIMBS;
+    using limbs_t = typename big_uint<Bits>::limbs_t;
+
+    constexpr big_int() = default;
+    // out-of-range values wrap modulo 2^Bits
+    template <typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    constexpr big_int(T a) : bits_(a) {}
+    constexpr explicit big_int(big_uint<Bits> const& a) : bits_(a) {}
+    explicit big_int(big_integer const& a) : bits_(a) {}
+    explicit big_int(std::string const& str) : big_int(big_integer(str)) {}
+
+    explicit operator big_integer() const {
+        return fixed_limbs::to_big_integer(bits_.limbs(), negative());
+    }
+    // the same bits read as unsigned
+    constexpr explicit operator big_uint<Bits>() const {
+        return bits_;
+    }
+    constexpr explicit operator bool() const {
+        return static_cast<bool>(bits_);
+    }
+
+    constexpr limbs_t const& limbs() const {
+        return bits_.limbs();
+    }
+    constexpr bool negative() const {
+        return (bits_.limbs()[LIMBS - 1] >> 31U) != 0;
+    }
+
+    constexpr big_int& operator+=(big_int const& rhs) {
+        bits_ += rhs.bits_;
+        return *this;
+    }
+    constexpr big_int& operator-=(big_int const& rhs) {
+        bits_ -= rhs.bits_;
+        return *this;
+    }
+    constexpr big_int& operator*=(big_int const& rhs) {
+        bits_ *= rhs.bits_;
+        return *this;
+    }
+    // quotient truncated toward zero, remainder with the sign of the dividend
+    constexpr big_int& operator/=(big_int const& rhs) {
+        bool negate = negative() != rhs.negative();
+        bits_ = abs_bits() / rhs.abs_bits();
+        if (negate) {
+            bits_ = -bits_;
+        }
+        return *this;
+    }
+    constexpr big_int& operator%=(big_int const& rhs) {
+        bool negate = negative();
+        bits_ = abs_bits() % rhs.abs_bits();
+        if (negate) {
+            bits_ = -bits_;
+        }
+        return *this;
+    }
+
+    constexpr big_int& operator&=(big_int const& rhs) {
+        bits_ &= rhs.bits_;
+        return *this;
+    }
+    constexpr big_int& operator|=(big_int const& rhs) {
+        bits_ |= rhs.bits_;
+        return *this;
+    }
+    constexpr big_int& operator^=(big_int const& rhs) {
+        bits_ ^= rhs.bits_;
+        return *this;
+    }
+
+    // a negative count shifts the other way
+    constexpr big_int& operator<<=(int rhs) {
+        if (rhs < 0) {
+            return shift_right(fixed_limbs::shift_count(rhs));
+        }
+        bits_ <<= rhs;
+        return *this;
+    }
+    // rounds toward minus infinity
+    constexpr big_int& operator>>=(int rhs) {
+        if (rhs < 0) {
+            bits_ >>= rhs;
+            return *this;
+        }
+        return shift_right(static_cast<size_t>(rhs));
+    }
+
+    constexpr big_int operator+() const {
+        return *this;
+    }
+    constexpr big_int operator-() const {
+        return big_int(-bits_);
+    }
+    constexpr big_int operator~() const {
+        return big_int(~bits_);
+    }
+
+    constexpr big_int& operator++() {
+        ++bits_;
+        return *this;
+    }
+    constexpr big_int operator++(int) {
+        big_int res = *this;
+        ++bits_;
+        return res;
+    }
+    constexpr big_int& operator--() {
+        --bits_;
+        return *this;
+    }
+    constexpr big_int operator--(int) {
+        big_int res = *this;
+        --bits_;
+        return res;
+    }
+
+    friend constexpr big_int operator+(big_int a, big_int const& b) { return a += b; }
+    friend constexpr big_int operator-(big_int a, big_int const& b) { return a -= b; }
+    friend constexpr big_int operator*(big_int a, big_int const& b) { return a *= b; }
+    friend constexpr big_int operator/(big_int a, big_int const& b) { return a /= b; }
+    friend constexpr big_int operator%(big_int a, big_int const& b) { return a %= b; }
+    friend constexpr big_int operator&(big_int a, big_int const& b) { return a &= b; }
+    friend constexpr big_int operator|(big_int a, big_int const& b) { return a |= b; }
+    friend constexpr big_int operator^(big_int a, big_int const& b) { return a ^= b; }
+    friend constexpr big_int operator<<(big_int a, int b) { return a <<= b; }
+    friend constexpr big_int operator>>(big_int a, int b) { return a >>= b; }
+
+    friend constexpr bool operator==(big_int const& a, big_int const& b) {
+        return a.bits_ == b.bits_;
+    }
+    friend constexpr bool operator!=(big_int const& a, big_int const& b) {
+        return !(a == b);
+    }
+    friend constexpr bool operator<(big_int const& a, big_int const& b) {
+        return a.negative() != b.negative() ? a.negative() : a.bits_ < b.bits_;
+    }
+    friend constexpr bool operator>(big_int const& a, big_int const& b) {
+        return b < a;
+    }
+    friend constexpr bool operator<=(big_int const& a, big_int const& b) {
+        return !(b < a);
+    }
+    friend constexpr bool operator>=(big_int const& a, big_int const& b) {
+        return !(a < b);
+    }
+
+private:
+    constexpr big_int& shift_right(size_t count) {
+        uint32_t fill = negative() ? UINT32_MAX : 0;
+        bits_ = big_uint<Bits>(fixed_limbs::shift_right(bits_.limbs(), count, fill));
+        return *this;
+    }
+
+    // |*this| as unsigned; the minimum value maps to itself, which is its magnitude
+    constexpr big_uint<Bits> abs_bits() const {
+        return negative() ? -bits_ : bits_;
+    }
+
+    big_uint<Bits> bits_;
+};
+
+template <size_t Bits>
+std::string to_string(big_uint<Bits> const& a) {
+    return to_string(big_integer(a));
+}
+
+template <size_t Bits>
+std::string to_string(big_int<Bits> const& a) {
+    return to_string(big_integer(a));
+}
+
+template <size_t Bits>
+std::ostream& operator<<(std::ostream& s, big_uint<Bits> const& a) {
+    return s << big_integer(a);
+}
+
+template <size_t Bits>
+std::ostream& operator<<(std::ostream& s, big_int<Bits> const& a) {
+    return s << big_integer(a);
+}
+
+using uint128 = big_uint<128>;
+using uint256 = big_uint<256>;
+using uint512 = big_uint<512>;
+using int128 = big_int<128>;
+using int256 = big_int<256>;
+using int512 = big_int<512>;
+
+#endif // FIXED_WIDTH_H
@@ -0,0 +1,133 @@
+// big_uint and big_int against big_integer: every operator at 96, 128, 256 and 512 bits, the
+// results of big_integer taken modulo 2^Bits. The static_asserts fail the build; the loops
+// compare random values at run time.
+// g++ -std=c++17 -O2 -pthread fixed_width_test.cpp big_integer.cpp limbs.cpp storage.cpp allocation.cpp parallel.cpp -o fixed_width_test
+
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include "fixed_width.h"
+
+// a negative count shifts the other way
+static_assert((uint128(8) << -2) == uint128(2), "");
+static_assert((uint128(8) >> -2) == uint128(32), "");
+static_assert((uint128(1) << -1) == uint128(0), "");
+static_assert((uint256(1) >> -255) == (uint256(1) << 255), "");
+static_assert((uint128(5) << INT_MIN) == uint128(0), "");
+static_assert((uint128(5) >> INT_MIN) == uint128(0), "");
+static_assert((int128(-8) << -2) == int128(-2), "");
+static_assert((int128(-7) << -1) == int128(-4), "");
+static_assert((int128(-3) >> -4) == int128(-48), "");
+static_assert((int128(-3) << INT_MIN) == int128(-1), "");
+
+// multiplication and division
+static_assert(uint128(0x123456789abcdefULL) * uint128(0xfedcba987654321ULL) / uint128(0xfedcba987654321ULL)
+              == uint128(0x123456789abcdefULL), "");
+static_assert(uint128(0x123456789abcdefULL) * uint128(0xfedcba987654321ULL) % uint128(0xfedcba987654321ULL)
+              == uint128(0), "");
+static_assert(uint128(-1) * uint128(-1) == uint128(1), "");
+static_assert((uint256(1) << 200) / (uint256(1) << 100) == (uint256(1) << 100), "");
+static_assert((uint256(1) << 200) % uint256(1000) == uint256(376), "");
+static_assert(big_uint<96>(UINT64_MAX) * big_uint<96>(UINT32_MAX) / big_uint<96>(UINT32_MAX)
+              == big_uint<96>(UINT64_MAX), "");
+static_assert(int256(-3) * int256(5) == int256(-15), "");
+static_assert(int512(-123456789) * int512(987654321) / int512(-987654321) == int512(123456789), "");
+
+// signed division truncates toward zero, the remainder takes the sign of the dividend
+static_assert(int128(-7) / int128(2) == int128(-3), "");
+static_assert(int128(-7) % int128(2) == int128(-1), "");
+static_assert(int128(7) / int128(-2) == int128(-3), "");
+static_assert(int128(7) % int128(-2) == int128(1), "");
+static_assert(int128(-7) / int128(-2) == int128(3), "");
+static_assert(int128(-7) % int128(-2) == int128(-1), "");
+static_assert((int128(1) << 127) / int128(-1) == (int128(1) << 127), "");
+
+// bitwise operations on negative values work on the two's complement
+static_assert((int128(-6) & int128(5)) == int128(0), "");
+static_assert((int128(-6) | int128(5)) == int128(-1), "");
+static_assert((int128(-6) ^ int128(-1)) == int128(5), "");
+static_assert(~int128(-6) == int128(5), "");
+static_assert((int256(-1) & (int256(1) << 200)) == (int256(1) << 200), "");
+
+namespace {
+    int failures = 0;
+
+    void fail(size_t bits, char const* op, big_integer const& x, big_integer const& y) {
+        std::printf("FAILED at %zu bits: %s %s %s\n", bits, to_string(x).c_str(), op, to_string(y).c_str());
+        ++failures;
+    }
+
+    template <typename T>
+    void check(T const& value, int count) {
+        big_integer x(value);
+        if (big_integer(value << count) != big_integer(T(x << count))
+            || big_integer(value >> count) != big_integer(T(x >> count))) {
+            fail(T::LIMBS * 32, count < 0 ? "<< (negative)" : "<<", x, big_integer(count));
+        }
+    }
+
+    template <typename T>
+    void check(T const& a, T const& b) {
+        big_integer x(a);
+        big_integer y(b);
+        auto expect = [&](char const* op, T const& got, big_integer const& want) {
+            if (got != T(want)) {
+                fail(T::LIMBS * 32, op, x, y);
+            }
+        };
+        expect("+", a + b, x + y);
+        expect("-", a - b, x - y);
+        expect("*", a * b, x * y);
+        if (b) {
+            expect("/", a / b, x / y);
+            expect("%", a % b, x % y);
+        }
+        expect("&", a & b, x & y);
+        expect("|", a | b, x | y);
+        expect("^", a ^ b, x ^ y);
+        expect("~", ~a, ~x);
+        expect("unary -", -a, -x);
+        if ((a == b) != (x == y) || (a != b) != (x != y) || (a < b) != (x < y)
+            || (a > b) != (x > y) || (a <= b) != (x <= y) || (a >= b) != (x >= y)) {
+            fail(T::LIMBS * 32, "<=>", x, y);
+        }
+    }
+
+    // a random number of low limbs set, sometimes with all the bits above them set as well,
+    // so that short divisors and values near the ends of the range come up
+    template <size_t Bits>
+    big_uint<Bits> random_bits(std::mt19937& gen) {
+        typename big_uint<Bits>::limbs_t limbs{};
+        size_t n = gen() % (big_uint<Bits>::LIMBS + 1);
+        bool ones = gen() % 4 == 0;
+        for (size_t i = 0; i < limbs.size(); ++i) {
+            limbs[i] = i < n ? static_cast<uint32_t>(gen()) : ones ? UINT32_MAX : 0;
+        }
+        return big_uint<Bits>(limbs);
+    }
+
+    template <size_t Bits>
+    void check_width(std::mt19937& gen, int rounds) {
+        for (int i = 0; i < rounds; ++i) {
+            big_uint<Bits> a = random_bits<Bits>(gen);
+            big_uint<Bits> b = random_bits<Bits>(gen);
+            check(a, b);
+            check(big_int<Bits>(a), big_int<Bits>(b));
+            int count = static_cast<int>(gen() % (2 * Bits + 101)) - static_cast<int>(Bits) - 50;
+            check(a, count);
+            check(big_int<Bits>(a), count);
+        }
+    }
+}
+
+int main() {
+    std::mt19937 gen(1);
+    check_width<96>(gen, 5000);
+    check_width<128>(gen, 5000);
+    check_width<256>(gen, 5000);
+    check_width<512>(gen, 2000);
+    std::printf("%s\n", failures == 0 ? "ok" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+#include "gcd.h"
+#include "limbs.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+    // Lehmer cofactors are kept below this so that a step is a mul_1 and a submul_1 per operand.
+    int64_t const COFACTOR_LIMIT = UINT32_MAX;
+
+    void trim(std::vector<uint32_t>& v) {
+        while (!v.empty() && v.back() == 0) {
+            v.pop_back();
+        }
+    }
+
+    // the 64 bits of v that start shift bits below its top limb, v longer than two limbs
+    uint64_t window(std::vector<uint32_t> const& v, uint32_t shift) {
+        size_t n = v.size();
+        uint64_t hi = (static_cast<uint64_t>(v[n - 1]) << 32U) | v[n - 2];
+        return shift == 0 ? hi : (hi << shift) | (v[n - 3] >> (32U - shift));
+    }
+
+    struct matrix {
+        int64_t a = 1, b = 0, c = 0, d = 1;
+    };
+
+    // Euclid on the leading bits x >= y of the operands as long as each quotient provably matches
+    // the one of the full numbers (Knuth, Algorithm L); the remainders after the accepted steps are
+    // a * x + b * y and c * x + d * y of the full operands
+    matrix lehmer_matrix(int64_t x, int64_t y) {
+        matrix m;
+        while (y + m.c > 0 && y + m.d > 0) {
+            int64_t q = (x + m.a) / (y + m.c);
+            if (q != (x + m.b) / (y + m.d)) {
+                break;
+            }
+            int64_t c = m.a - q * m.c;
+            int64_t d = m.b - q * m.d;
+            if (c < -COFACTOR_LIMIT || c > COFACTOR_LIMIT || d < -COFACTOR_LIMIT || d > COFACTOR_LIMIT) {
+                break;
+            }
+            m = {m.c, m.d, c, d};
+            int64_t r = x - q * y;
+            x = y;
+            y = r;
+        }
+        return m;
+    }
+
+    // r = s * x + t * y for s and t of opposite signs (or zero) and a nonnegative result, y no longer than x
+    void combine(std::vector<uint32_t>& r, std::vector<uint32_t> const& x, std::vector<uint32_t> const& y,
+                 int64_t s, int64_t t) {
+        bool x_positive = s > 0 || (s == 0 && t < 0);
+        std::vector<uint32_t> const& p = x_positive ? x : y;
+        std::vector<uint32_t> const& n = x_positive ? y : x;
+        uint32_t pm = static_cast<uint32_t>(x_positive ? s : t);
+        uint32_t nm = static_cast<uint32_t>(x_positive ? -t : -s);
+        r.assign(x.size() + 1, 0);
+        r[p.size()] = limbs::mul_1(r.data(), p.data(), p.size(), pm);
+        uint32_t borrow = limbs::submul_1(r.data(), n.data(), n.size(), nm);
+        limbs::sub(r.data() + n.size(), r.data() + n.size(), r.size() - n.size(), &borrow, 1);
+        trim(r);
+    }
+
+    // (x, y) = (y, x mod y), q = x / y
+    void divide_step(std::vector<uint32_t>& x, std::vector<uint32_t>& y, std::vector<uint32_t>& q) {
+        q.assign(x.size() - y.size() + 1, 0);
+        std::vector<uint32_t> r(y.size());
+        limbs::divrem(q.data(), r.data(), x.data(), x.size(), y.data(), y.size());
+        trim(q);
+        trim(r);
+        x = std::move(y);
+        y = std::move(r);
+    }
+
+    big_integer from_limbs(std::vector<uint32_t> v) {
+        trim(v);
+        return v.empty() ? big_integer(0) : big_integer(1, std::vector<uint32_t>(v.rbegin(), v.rend()));
+    }
+
+    bool less(std::vector<uint32_t> const& x, std::vector<uint32_t> const& y) {
+        if (x.size() != y.size()) {
+            return x.size() < y.size();
+        }
+        return limbs::cmp(x.data(), y.data(), x.size()) < 0;
+    }
+
+    big_integer from_cofactor(int64_t v) {
+        big_integer res(static_cast<uint32_t>(v < 0 ? -v : v));
+        return v < 0 ? -res : res;
+    }
+
+    // coefficients of the first operand in (x, y), kept up to date by gcdext
+    struct cofactors {
+        big_integer s0 = 1;
+        big_integer s1 = 0;
+
+        void apply(matrix const& m) {
+            big_integer t = s0 * from_cofactor(m.c) + s1 * from_cofactor(m.d);
+            s0 = s0 * from_cofactor(m.a) + s1 * from_cofactor(m.b);
+            s1 = std::move(t);
+        }
+
+        void apply(std::vector<uint32_t> const& q) {
+            big_integer t = s0 - from_limbs(q) * s1;
+            s0 = std::move(s1);
+            s1 = std::move(t);
+        }
+    };
+
+    // Reduces (x, y) with x >= y while y is longer than stop limbs; s, when given, follows the steps.
+    void lehmer(std::vector<uint32_t>& x, std::vector<uint32_t>& y, size_t stop, cofactors* s) {
+        std::vector<uint32_t> q;
+        std::vector<uint32_t> nx;
+        std::vector<uint32_t> ny;
+        while (y.size() > stop) {
+            matrix m;
+            size_t n = x.size();
+            if (n == y.size() && n >= 3) {
+                uint32_t shift = __builtin_clz(x[n - 1]);
+                // 62 leading bits leave room for the cofactor sums in int64_t
+                m = lehmer_matrix(static_cast<int64_t>(window(x, shift) >> 2U),
+                                  static_cast<int64_t>(window(y, shift) >> 2U));
+            }
+            if (m.b == 0) {
+                divide_step(x, y, q);
+                if (s != nullptr) {
+                    s->apply(q);
+                }
+                continue;
+            }
+            combine(nx, x, y, m.a, m.b);
+            combine(ny, x, y, m.c, m.d);
+            std::swap(x, nx);
+            std::swap(y, ny);
+            if (s != nullptr) {
+                s->apply(m);
+            }
+        }
+    }
+
+    uint64_t to_uint64(std::vector<uint32_t> const& v) {
+        uint64_t res = 0;
+        for (size_t i = v.size(); i > 0; --i) {
+            res = (res << 32U) | v[i - 1];
+        }
+        return res;
+    }
+
+    uint64_t binary_gcd(uint64_t a, uint64_t b) {
+        if (a == 0 || b == 0) {
+            return a | b;
+        }
+        int shift = __builtin_ctzll(a | b);
+        a >>= __builtin_ctzll(a);
+        while (b != 0) {
+            b >>= __builtin_ctzll(b);
+            if (a > b) {
+                std::swap(a, b);
+            }
+            b -= a;
+        }
+        return a << shift;
+    }
+}
+
+big_integer gcd(big_integer const& a, big_integer const& b) {
+    std::vector<uint32_t> x(a.words.begin(), a.words.end());
+    std::vector<uint32_t> y(b.words.begin(), b.words.end());
+    if (less(x, y)) {
+        std::swap(x, y);
+    }
+    lehmer(x, y, 2, nullptr);
+    if (y.empty()) {
+        return from_limbs(x);
+    }
+    if (x.size() > 2) {
+        std::vector<uint32_t> q;
+        divide_step(x, y, q);
+    }
+    uint64_t g = binary_gcd(to_uint64(x), to_uint64(y));
+    return from_limbs({static_cast<uint32_t>(g), static_cast<uint32_t>(g >> 32U)});
+}
+
+std::tuple<big_integer, big_integer, big_integer> gcdext(big_integer const& a, big_integer const& b) {
+    std::vector<uint32_t> x(a.words.begin(), a.words.end());
+    std::vector<uint32_t> y(b.words.begin(), b.words.end());
+    cofactors s;
+    if (less(x, y)) {
+        std::swap(x, y);
+        std::swap(s.s0, s.s1);
+    }
+    lehmer(x, y, 0, &s);
+    big_integer g = from_limbs(x);
+    // t follows from g = s * |a| + t * |b|; b = 0 leaves g = |a| and s = 1
+    big_integer abs_a = a.sign < 0 ? -a : a;
+    big_integer abs_b = b.sign < 0 ? -b : b;
+    big_integer t = b.sign == 0 ? big_integer(0) : (g - s.s0 * abs_a) / abs_b;
+    big_integer s0 = a.sign < 0 ? -s.s0 : s.s0;
+    return std::make_tuple(std::move(g), std::move(s0), b.sign < 0 ? -t : t);
+}
+
+big_integer modinv(big_integer const& a, big_integer const& m) {
+    if (m <= 0) {
+        throw std::runtime_error("Invalid modulus");
+    }
+    big_integer r = a % m;
+    std::tuple<big_integer, big_integer, big_integer> res = gcdext(r < 0 ? r + m : r, m);
+    if (std::get<0>(res) != 1) {
+        throw std::runtime_error("Not invertible");
+    }
+    big_integer x = std::get<1>(res) % m;
+    return x < 0 ? x + m : x;
+}
@@ -0,0 +1,16 @@
+#ifndef GCD_H
+#define GCD_H
+
+#include <tuple>
+
+#include "big_integer.h"
+
+// gcd(a, b) >= 0 with gcd(0, 0) = 0: Lehmer steps on the leading 62 bits while the operands are
+// longer than two limbs, then a binary gcd on machine words.
+big_integer gcd(big_integer const& a, big_integer const& b);
+// (g, s, t) with g = gcd(a, b) = s * a + t * b
+std::tuple<big_integer, big_integer, big_integer> gcdext(big_integer const& a, big_integer const& b);
+// x in [0, m) with a * x = 1 mod m; m > 0 and gcd(a, m) = 1
+big_integer modinv(big_integer const& a, big_integer const& m);
+
+#endif // GCD_H
@@ -0,0 +1,1235 @@
+#include "limbs.h"
+#include "allocation.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define LIMBS_HAVE_ADDCARRY
+#endif
+
+// Bitwise kernels take eight limbs per step when the target has AVX2 (-mavx2 or -march=native).
+#ifdef __AVX2__
+#define LIMBS_HAVE_AVX2
+#endif
+
+// Build with -DBIG_INTEGER_ASM and link long_arith/liblong_arith.a to run the basecase
+// kernels through the hand-written assembly; limbs are then handled in qword pairs.
+#ifdef BIG_INTEGER_ASM
+#include "../long_arith/long_arith.h"
+#endif
+
+namespace {
+    // Operand sizes (in limbs) from which the recursive algorithms beat the basecase.
+    size_t const KARATSUBA_THRESHOLD = 48;
+    size_t const TOOM3_THRESHOLD = 100;
+    size_t const NTT_THRESHOLD = 1500;
+    // Longest transform all three NTT primes support; also keeps every product coefficient below their product.
+    size_t const NTT_MAX_LENGTH = size_t(1) << 23U;
+    // Divisor and quotient sizes (in limbs) from which Burnikel-Ziegler and Newton division take over.
+    size_t const BZ_THRESHOLD = 40;
+    size_t const NEWTON_THRESHOLD = 150000;
+    // Sub-product size (in limbs) and NTT length from which the parallel mode hands work to the pool.
+    size_t const PARALLEL_THRESHOLD = 1000;
+    size_t const PARALLEL_NTT_LENGTH = size_t(1) << 15U;
+    // Dividend length (in limbs) from which a single-limb division pays for computing the reciprocal.
+    size_t const DIVREM_1_PREINV_THRESHOLD = 4;
+
+    // temporaries of the recursive algorithms, taken from the thread's scratch stack; each thread has
+    // its own, so buffers that pool tasks write to are sized by the thread that hands the tasks out
+    using buffer = std::vector<uint32_t, scratch::allocator<uint32_t>>;
+
+    size_t normalized_size(uint32_t const* a, size_t n) {
+        while (n > 0 && a[n - 1] == 0) {
+            --n;
+        }
+        return n;
+    }
+
+    // Carry-chain steps on 64-bit units; with _addcarry_u64 the whole loop stays in adc/sbb.
+    // There is no ADX/BMI2 dispatch: add and sub have a single carry chain, which adcx/adox cannot
+    // split, and a mulx/adcx/adox addmul_1 behind __builtin_cpu_supports ran at 0.29 limbs per cycle
+    // against 0.32 for the plain loop, as GCC serializes the two flag chains through setc
+    // (bench_limbs.cpp has the current figures).
+    inline uint64_t add_carry(uint64_t a, uint64_t b, unsigned char& carry) {
+#ifdef LIMBS_HAVE_ADDCARRY
+        unsigned long long res;
+        carry = _addcarry_u64(carry, a, b, &res);
+        return res;
+#else
+        uint64_t res = a + b;
+        unsigned char out = res < a;
+        res += carry;
+        carry = out | (res < carry);
+        return res;
+#endif
+    }
+
+    inline uint64_t sub_borrow(uint64_t a, uint64_t b, unsigned char& borrow) {
+#ifdef LIMBS_HAVE_ADDCARRY
+        unsigned long long res;
+        borrow = _subborrow_u64(borrow, a, b, &res);
+        return res;
+#else
+        uint64_t res = a - b;
+        unsigned char out = a < b;
+        out |= res < borrow;
+        res -= borrow;
+        borrow = out;
+        return res;
+#endif
+    }
+
+    // two limbs as one unit, low limb first
+    inline uint64_t load_2(uint32_t const* p) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+#else
+        return p[0] | static_cast<uint64_t>(p[1]) << 32U;
+#endif
+    }
+
+    inline void store_2(uint32_t* p, uint64_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        std::memcpy(p, &v, sizeof(v));
+#else
+        p[0] = static_cast<uint32_t>(v);
+        p[1] = static_cast<uint32_t>(v >> 32U);
+#endif
+    }
+
+#ifdef BIG_INTEGER_ASM
+    inline uint64_t* as_qwords(uint32_t* p) {
+        return reinterpret_cast<uint64_t*>(p);
+    }
+
+    inline uint64_t const* as_qwords(uint32_t const* p) {
+        return reinterpret_cast<uint64_t const*>(p);
+    }
+#endif
+
+    // word operations of the bitwise kernels, scalar and (with AVX2) on eight limbs at once
+    struct and_op {
+        uint32_t operator()(uint32_t a, uint32_t b) const { return a & b; }
+#ifdef LIMBS_HAVE_AVX2
+        __m256i operator()(__m256i a, __m256i b) const { return _mm256_and_si256(a, b); }
+#endif
+    };
+
+    struct ior_op {
+        uint32_t operator()(uint32_t a, uint32_t b) const { return a | b; }
+#ifdef LIMBS_HAVE_AVX2
+        __m256i operator()(__m256i a, __m256i b) const { return _mm256_or_si256(a, b); }
+#endif
+    };
+
+    struct xor_op {
+        uint32_t operator()(uint32_t a, uint32_t b) const { return a ^ b; }
+#ifdef LIMBS_HAVE_AVX2
+        __m256i operator()(__m256i a, __m256i b) const { return _mm256_xor_si256(a, b); }
+#endif
+    };
+
+    struct andn_op {
+        uint32_t operator()(uint32_t a, uint32_t b) const { return a & ~b; }
+#ifdef LIMBS_HAVE_AVX2
+        __m256i operator()(__m256i a, __m256i b) const { return _mm256_andnot_si256(b, a); }
+#endif
+    };
+
+    template <typename Op>
+    void bitwise_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n, Op op) {
+        size_t i = 0;
+#ifdef LIMBS_HAVE_AVX2
+        for (; i + 8 <= n; i += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), op(x, y));
+        }
+#endif
+        for (; i < n; ++i) {
+            r[i] = op(a[i], b[i]);
+        }
+    }
+
+    void trim(buffer& v) {
+        while (!v.empty() && v.back() == 0) {
+            v.pop_back();
+        }
+    }
+
+    // Intermediate value of Toom-Cook interpolation, which can go negative.
+    struct signed_value {
+        buffer mag;
+        bool negative = false;
+    };
+
+    signed_value make_value(uint32_t const* a, size_t n) {
+        signed_value res;
+        res.mag.assign(a, a + normalized_size(a, n));
+        return res;
+    }
+
+    int32_t compare_magnitude(buffer const& x, buffer const& y) {
+        if (x.size() != y.size()) {
+            return x.size() < y.size() ? -1 : 1;
+        }
+        return limbs::cmp(x.data(), y.data(), x.size());
+    }
+
+    signed_value add_values(signed_value const& x, signed_value const& y, bool negate_y) {
+        bool y_negative = (y.negative != negate_y) && !y.mag.empty();
+        signed_value res;
+        if (x.negative == y_negative) {
+            buffer const& big = x.mag.size() >= y.mag.size() ? x.mag : y.mag;
+            buffer const& small = x.mag.size() >= y.mag.size() ? y.mag : x.mag;
+            res.mag.resize(big.size() + 1);
+            res.mag[big.size()] = limbs::add(res.mag.data(), big.data(), big.size(), small.data(), small.size());
+            res.negative = x.negative;
+        } else {
+            int32_t cmp = compare_magnitude(x.mag, y.mag);
+            buffer const& big = cmp >= 0 ? x.mag : y.mag;
+            buffer const& small = cmp >= 0 ? y.mag : x.mag;
+            res.mag.resize(big.size());
+            limbs::sub(res.mag.data(), big.data(), big.size(), small.data(), small.size());
+            res.negative = cmp >= 0 ? x.negative : y_negative;
+        }
+        trim(res.mag);
+        if (res.mag.empty()) {
+            res.negative = false;
+        }
+        return res;
+    }
+
+    // res = x * y in the capacity res already has, when it is enough
+    void mul_values(signed_value& res, signed_value const& x, signed_value const& y) {
+        res.mag.clear();
+        res.negative = false;
+        if (x.mag.empty() || y.mag.empty()) {
+            return;
+        }
+        res.mag.resize(x.mag.size() + y.mag.size());
+        if (&x == &y) {
+            limbs::sqr(res.mag.data(), x.mag.data(), x.mag.size());
+        } else {
+            limbs::mul(res.mag.data(), x.mag.data(), x.mag.size(), y.mag.data(), y.mag.size());
+        }
+        trim(res.mag);
+        res.negative = x.negative != y.negative;
+    }
+
+    void shift_left_1(signed_value& x) {
+        x.mag.push_back(0);
+        for (size_t i = x.mag.size() - 1; i > 0; --i) {
+            x.mag[i] = (x.mag[i] << 1U) | (x.mag[i - 1] >> 31U);
+        }
+        x.mag[0] <<= 1U;
+        trim(x.mag);
+    }
+
+    void shift_right_1(signed_value& x) {
+        for (size_t i = 0; i < x.mag.size(); ++i) {
+            x.mag[i] = (x.mag[i] >> 1U) | (i + 1 < x.mag.size() ? x.mag[i + 1] << 31U : 0);
+        }
+        trim(x.mag);
+    }
+
+    void divide_exact_3(signed_value& x) {
+        uint64_t rest = 0;
+        for (size_t i = x.mag.size(); i > 0; --i) {
+            uint64_t cur = (rest << 32U) | x.mag[i - 1];
+            x.mag[i - 1] = static_cast<uint32_t>(cur / 3);
+            rest = cur % 3;
+        }
+        trim(x.mag);
+    }
+
+    // r[0..rn) += x, x is known to be non-negative and to fit
+    void add_value(uint32_t* r, size_t rn, signed_value const& x) {
+        if (!x.mag.empty()) {
+            limbs::add(r, r, rn, x.mag.data(), x.mag.size());
+        }
+    }
+
+    void mul_rec(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn);
+
+    void mul_basecase(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+#ifdef BIG_INTEGER_ASM
+        // even parts in qwords, then the odd top limb of each operand as a row of its own
+        size_t ae = an & ~size_t(1);
+        size_t be = bn & ~size_t(1);
+        if (ae != 0 && be != 0) {
+            mul_long_long(as_qwords(r), as_qwords(a), ae / 2, as_qwords(b), be / 2);
+            std::fill(r + ae + be, r + an + bn, 0);
+        } else {
+            std::fill(r, r + an + bn, 0);
+        }
+        if (be != bn) {
+            r[ae + bn - 1] = limbs::addmul_1(r + bn - 1, a, ae, b[bn - 1]);
+        }
+        if (ae != an) {
+            r[an + bn - 1] = limbs::addmul_1(r + an - 1, b, bn, a[an - 1]);
+        }
+#else
+        r[an] = limbs::mul_1(r, a, an, b[0]);
+        for (size_t i = 1; i < bn; ++i) {
+            r[an + i] = limbs::addmul_1(r + i, a, an, b[i]);
+        }
+#endif
+    }
+
+    void sqr_basecase(uint32_t* r, uint32_t const* a, size_t n) {
+        std::fill(r, r + 2 * n, 0);
+        for (size_t i = 0; i + 1 < n; ++i) {
+            r[n + i] = limbs::addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+        }
+        for (size_t i = 2 * n - 1; i > 0; --i) {
+            r[i] = (r[i] << 1U) | (r[i - 1] >> 31U);
+        }
+        r[0] <<= 1U;
+        buffer diagonal(2 * n);
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t sq = static_cast<uint64_t>(a[i]) * a[i];
+            diagonal[2 * i] = static_cast<uint32_t>(sq);
+            diagonal[2 * i + 1] = static_cast<uint32_t>(sq >> 32U);
+        }
+        limbs::add_n(r, r, diagonal.data(), 2 * n);
+    }
+
+    // an is much larger than bn: multiply b by bn-sized slices of a
+    void mul_unbalanced(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        mul_rec(r, a, bn, b, bn);
+        std::fill(r + 2 * bn, r + an + bn, 0);
+        buffer tmp(2 * bn);
+        for (size_t i = bn; i < an; i += bn) {
+            size_t len = std::min(bn, an - i);
+            limbs::mul(tmp.data(), b, bn, a + i, len);
+            limbs::add(r + i, r + i, an + bn - i, tmp.data(), len + bn);
+        }
+    }
+
+    // (a1 * x + a0) * (b1 * x + b0) with x = B^h and a middle term (a0 + a1) * (b0 + b1) - z0 - z2
+    void mul_karatsuba(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        bool square = (a == b && an == bn);
+        size_t h = (an + 1) / 2;
+        buffer sa(h + 1);
+        buffer sb(h + 1);
+        sa[h] = limbs::add(sa.data(), a, h, a + h, an - h);
+        if (!square) {
+            sb[h] = limbs::add(sb.data(), b, h, b + h, bn - h);
+        }
+        buffer mid(2 * h + 2);
+        auto middle = [&] {
+            if (square) {
+                limbs::sqr(mid.data(), sa.data(), h + 1);
+            } else {
+                limbs::mul(mid.data(), sa.data(), h + 1, sb.data(), h + 1);
+            }
+        };
+        auto low = [&] {
+            if (square) {
+                limbs::sqr(r, a, h);
+            } else {
+                limbs::mul(r, a, h, b, h);
+            }
+        };
+        auto high = [&] {
+            if (square) {
+                limbs::sqr(r + 2 * h, a + h, an - h);
+            } else {
+                limbs::mul(r + 2 * h, a + h, an - h, b + h, bn - h);
+            }
+        };
+        if (h >= PARALLEL_THRESHOLD && parallel::threads() > 1) {
+            parallel::invoke_all({middle, low, high});
+        } else {
+            middle();
+            low();
+            high();
+        }
+        limbs::sub(mid.data(), mid.data(), mid.size(), r, 2 * h);
+        limbs::sub(mid.data(), mid.data(), mid.size(), r + 2 * h, an + bn - 2 * h);
+        limbs::add(r + h, r + h, an + bn - h, mid.data(), normalized_size(mid.data(), mid.size()));
+    }
+
+    // Toom-Cook 3-way with evaluation points 0, 1, -1, -2, inf and Bodrato's interpolation sequence
+    void mul_toom3(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        bool square = (a == b && an == bn);
+        size_t k = (an + 2) / 3;
+        size_t n = an + bn;
+
+        signed_value a0 = make_value(a, k);
+        signed_value a1 = make_value(a + k, k);
+        signed_value a2 = make_value(a + 2 * k, an - 2 * k);
+        signed_value b0 = make_value(b, k);
+        signed_value b1 = make_value(b + k, k);
+        signed_value b2 = make_value(b + 2 * k, bn - 2 * k);
+
+        signed_value pa = add_values(a0, a2, false);
+        signed_value a_1 = add_values(pa, a1, false);
+        signed_value a_m1 = add_values(pa, a1, true);
+        signed_value a_m2 = add_values(a_m1, a2, false);
+        shift_left_1(a_m2);
+        a_m2 = add_values(a_m2, a0, true);
+
+        signed_value b_1;
+        signed_value b_m1;
+        signed_value b_m2;
+        if (!square) {
+            signed_value pb = add_values(b0, b2, false);
+            b_1 = add_values(pb, b1, false);
+            b_m1 = add_values(pb, b1, true);
+            b_m2 = add_values(b_m1, b2, false);
+            shift_left_1(b_m2);
+            b_m2 = add_values(b_m2, b0, true);
+        }
+
+        // the five point products are independent
+        signed_value r_1;
+        signed_value r_m1;
+        signed_value r_m2;
+        r_1.mag.reserve(a_1.mag.size() + (square ? a_1 : b_1).mag.size());
+        r_m1.mag.reserve(a_m1.mag.size() + (square ? a_m1 : b_m1).mag.size());
+        r_m2.mag.reserve(a_m2.mag.size() + (square ? a_m2 : b_m2).mag.size());
+        std::fill(r, r + n, 0);
+        auto at_1 = [&] { mul_values(r_1, a_1, square ? a_1 : b_1); };
+        auto at_m1 = [&] { mul_values(r_m1, a_m1, square ? a_m1 : b_m1); };
+        auto at_m2 = [&] { mul_values(r_m2, a_m2, square ? a_m2 : b_m2); };
+        auto at_0 = [&] {
+            if (square) {
+                limbs::sqr(r, a, k);
+            } else {
+                limbs::mul(r, a, k, b, k);
+            }
+        };
+        auto at_inf = [&] {
+            if (square) {
+                limbs::sqr(r + 4 * k, a + 2 * k, an - 2 * k);
+            } else {
+                limbs::mul(r + 4 * k, a + 2 * k, an - 2 * k, b + 2 * k, bn - 2 * k);
+            }
+        };
+        if (k >= PARALLEL_THRESHOLD && parallel::threads() > 1) {
+            parallel::invoke_all({at_1, at_m1, at_m2, at_0, at_inf});
+        } else {
+            at_1();
+            at_m1();
+            at_m2();
+            at_0();
+            at_inf();
+        }
+        signed_value r_0 = make_value(r, 2 * k);
+        signed_value r_inf = make_value(r + 4 * k, n - 4 * k);
+
+        signed_value r_3 = add_values(r_m2, r_1, true);
+        divide_exact_3(r_3);
+        r_1 = add_values(r_1, r_m1, true);
+        shift_right_1(r_1);
+        signed_value r_2 = add_values(r_m1, r_0, true);
+        r_3 = add_values(r_2, r_3, true);
+        shift_right_1(r_3);
+        signed_value twice_inf = r_inf;
+        shift_left_1(twice_inf);
+        r_3 = add_values(r_3, twice_inf, false);
+        r_2 = add_values(r_2, r_1, false);
+        r_2 = add_values(r_2, r_inf, true);
+        r_1 = add_values(r_1, r_3, true);
+
+        add_value(r + k, n - k, r_1);
+        add_value(r + 2 * k, n - 2 * k, r_2);
+        add_value(r + 3 * k, n - 3 * k, r_3);
+    }
+
+    template <uint32_t MOD>
+    uint32_t power_mod(uint32_t a, uint32_t e) {
+        uint64_t res = 1;
+        uint64_t cur = a;
+        while (e != 0) {
+            if (e & 1U) {
+                res = res * cur % MOD;
+            }
+            cur = cur * cur % MOD;
+            e >>= 1U;
+        }
+        return static_cast<uint32_t>(res);
+    }
+
+    // In-place number-theoretic transform modulo a prime c * 2^k + 1 with primitive root ROOT
+    template <uint32_t MOD, uint32_t ROOT>
+    void ntt(uint32_t* a, size_t n, bool invert) {
+        for (size_t i = 1, j = 0; i < n; ++i) {
+            size_t bit = n >> 1U;
+            for (; j & bit; bit >>= 1U) {
+                j ^= bit;
+            }
+            j ^= bit;
+            if (i < j) {
+                std::swap(a[i], a[j]);
+            }
+        }
+        buffer w(n / 2);
+        for (size_t len = 2; len <= n; len <<= 1U) {
+            uint32_t w_len = power_mod<MOD>(ROOT, static_cast<uint32_t>((MOD - 1) / len));
+            if (invert) {
+                w_len = power_mod<MOD>(w_len, MOD - 2);
+            }
+            size_t half = len / 2;
+            w[0] = 1;
+            for (size_t j = 1; j < half; ++j) {
+                w[j] = static_cast<uint32_t>(static_cast<uint64_t>(w[j - 1]) * w_len % MOD);
+            }
+            // butterflies first..last - 1 of the n / 2 in this pass, they touch disjoint pairs
+            uint32_t* p = a;
+            uint32_t const* wp = w.data();
+            auto butterflies = [p, wp, half, len](size_t first, size_t last) {
+                size_t i = first / half * len;
+                size_t j = first % half;
+                while (first < last) {
+                    size_t end = std::min(half, j + (last - first));
+                    first += end - j;
+                    for (; j < end; ++j) {
+                        uint32_t u = p[i + j];
+                        uint32_t v = static_cast<uint32_t>(static_cast<uint64_t>(p[i + j + half]) * wp[j] % MOD);
+                        p[i + j] = u + v < MOD ? u + v : u + v - MOD;
+                        p[i + j + half] = u >= v ? u - v : u + MOD - v;
+                    }
+                    j = 0;
+                    i += len;
+                }
+            };
+            if (n >= PARALLEL_NTT_LENGTH && parallel::threads() > 1) {
+                parallel::for_range(0, n / 2, butterflies);
+            } else {
+                butterflies(0, n / 2);
+            }
+        }
+        if (invert) {
+            uint64_t n_inv = power_mod<MOD>(static_cast<uint32_t>(n % MOD), MOD - 2);
+            for (size_t i = 0; i < n; ++i) {
+                a[i] = static_cast<uint32_t>(a[i] * n_inv % MOD);
+            }
+        }
+    }
+
+    // Cyclic convolution of a and b (or of a with itself) modulo MOD, result left in fa[0..len)
+    template <uint32_t MOD, uint32_t ROOT>
+    void convolve_mod(uint32_t* fa, uint32_t const* a, size_t an, uint32_t const* b, size_t bn, size_t len) {
+        bool square = (a == b && an == bn);
+        std::fill(fa, fa + len, 0);
+        for (size_t i = 0; i < an; ++i) {
+            fa[i] = a[i] % MOD;
+        }
+        if (square) {
+            ntt<MOD, ROOT>(fa, len, false);
+            for (size_t i = 0; i < len; ++i) {
+                fa[i] = static_cast<uint32_t>(static_cast<uint64_t>(fa[i]) * fa[i] % MOD);
+            }
+        } else {
+            buffer fb(len, 0);
+            for (size_t i = 0; i < bn; ++i) {
+                fb[i] = b[i] % MOD;
+            }
+            if (len >= PARALLEL_NTT_LENGTH && parallel::threads() > 1) {
+                parallel::invoke([fa, len] { ntt<MOD, ROOT>(fa, len, false); },
+                                 [&fb, len] { ntt<MOD, ROOT>(fb.data(), len, false); });
+            } else {
+                ntt<MOD, ROOT>(fa, len, false);
+                ntt<MOD, ROOT>(fb.data(), len, false);
+            }
+            for (size_t i = 0; i < len; ++i) {
+                fa[i] = static_cast<uint32_t>(static_cast<uint64_t>(fa[i]) * fb[i] % MOD);
+            }
+        }
+        ntt<MOD, ROOT>(fa, len, true);
+    }
+
+    uint32_t const NTT_P1 = 998244353;  // 119 * 2^23 + 1
+    uint32_t const NTT_P2 = 167772161;  // 5 * 2^25 + 1
+    uint32_t const NTT_P3 = 469762049;  // 7 * 2^26 + 1
+
+    // Three-prime NTT product, coefficients are reconstructed with the CRT and carried into 32-bit limbs
+    void mul_ntt(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        size_t len = 1;
+        while (len < an + bn) {
+            len <<= 1U;
+        }
+        buffer c1(len);
+        buffer c2(len);
+        buffer c3(len);
+        auto mod_p1 = [&] { convolve_mod<NTT_P1, 3>(c1.data(), a, an, b, bn, len); };
+        auto mod_p2 = [&] { convolve_mod<NTT_P2, 3>(c2.data(), a, an, b, bn, len); };
+        auto mod_p3 = [&] { convolve_mod<NTT_P3, 3>(c3.data(), a, an, b, bn, len); };
+        if (parallel::threads() > 1) {
+            parallel::invoke_all({mod_p1, mod_p2, mod_p3});
+        } else {
+            mod_p1();
+            mod_p2();
+            mod_p3();
+        }
+
+        uint64_t const p1_inv_p2 = power_mod<NTT_P2>(NTT_P1 % NTT_P2, NTT_P2 - 2);
+        uint64_t const p1p2_mod_p3 = static_cast<uint64_t>(NTT_P1) * NTT_P2 % NTT_P3;
+        uint64_t const p1p2_inv_p3 = power_mod<NTT_P3>(static_cast<uint32_t>(p1p2_mod_p3), NTT_P3 - 2);
+        unsigned __int128 const p1p2 = static_cast<unsigned __int128>(NTT_P1) * NTT_P2;
+
+        unsigned __int128 carry = 0;
+        for (size_t i = 0; i < an + bn; ++i) {
+            uint64_t x1 = c1[i];
+            uint64_t t1 = (c2[i] + NTT_P2 - x1 % NTT_P2) * p1_inv_p2 % NTT_P2;
+            uint64_t x12 = x1 + t1 * NTT_P1;
+            uint64_t t2 = (c3[i] + NTT_P3 - x12 % NTT_P3) * p1p2_inv_p3 % NTT_P3;
+            carry += x12 + p1p2 * t2;
+            r[i] = static_cast<uint32_t>(carry);
+            carry >>= 32U;
+        }
+    }
+
+    // an >= bn >= 1, both normalized
+    void mul_rec(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        if (bn >= NTT_THRESHOLD && an + bn <= NTT_MAX_LENGTH) {
+            mul_ntt(r, a, an, b, bn);
+        } else if (bn < KARATSUBA_THRESHOLD) {
+            if (a == b && an == bn) {
+                sqr_basecase(r, a, an);
+            } else {
+                mul_basecase(r, a, an, b, bn);
+            }
+        } else if (bn <= (an + 1) / 2) {
+            mul_unbalanced(r, a, an, b, bn);
+        } else if (bn < TOOM3_THRESHOLD || bn <= 2 * ((an + 2) / 3)) {
+            mul_karatsuba(r, a, an, b, bn);
+        } else {
+            mul_toom3(r, a, an, b, bn);
+        }
+    }
+
+    // (u1 * B + u0) / d for normalized d and u1 < d, with v = invert_1(d): Moller-Granlund, Algorithm 4
+    inline uint32_t div_2by1(uint32_t& r, uint32_t u1, uint32_t u0, uint32_t d, uint32_t v) {
+        uint64_t q = static_cast<uint64_t>(v) * u1 + ((static_cast<uint64_t>(u1) << 32U) | u0);
+        uint32_t q1 = static_cast<uint32_t>(q >> 32U) + 1;
+        uint32_t q0 = static_cast<uint32_t>(q);
+        r = u0 - q1 * d;
+        if (r > q0) {
+            --q1;
+            r += d;
+        }
+        if (r >= d) {
+            ++q1;
+            r -= d;
+        }
+        return q1;
+    }
+
+    // (u2 * B^2 + u1 * B + u0) / d for the normalized two-limb d and (u2, u1) < d,
+    // with v = invert_2(d): Moller-Granlund, Algorithm 5
+    inline uint32_t div_3by2(uint64_t& r, uint32_t u2, uint32_t u1, uint32_t u0, uint64_t d, uint32_t v) {
+        uint32_t d1 = static_cast<uint32_t>(d >> 32U);
+        uint64_t q = static_cast<uint64_t>(v) * u2 + ((static_cast<uint64_t>(u2) << 32U) | u1);
+        uint32_t q1 = static_cast<uint32_t>(q >> 32U);
+        uint32_t q0 = static_cast<uint32_t>(q);
+        uint32_t r1 = u1 - q1 * d1;
+        r = ((static_cast<uint64_t>(r1) << 32U) | u0) - static_cast<uint64_t>(static_cast<uint32_t>(d)) * q1 - d;
+        ++q1;
+        if (static_cast<uint32_t>(r >> 32U) >= q0) {
+            --q1;
+            r += d;
+        }
+        if (r >= d) {
+            ++q1;
+            r -= d;
+        }
+        return q1;
+    }
+
+    // a[0..an) / b[0..bn) with bn >= 2, b normalized (top bit set), v = invert_2 of its top limbs
+    // and a < b * B^(an - bn): the quotient goes to q[0..an - bn), the remainder to a[0..bn)
+    // and a[bn..an) is zeroed
+    void divrem_basecase(uint32_t* q, uint32_t* a, size_t an, uint32_t const* b, size_t bn, uint32_t v) {
+        uint64_t top = (static_cast<uint64_t>(b[bn - 1]) << 32U) | b[bn - 2];
+        for (size_t j = an - bn; j > 0; --j) {
+            uint32_t* cur = a + j - 1;
+            if (cur[bn] == b[bn - 1] && cur[bn - 1] == b[bn - 2]) {
+                // the estimate B - 1 is exact here
+                cur[bn] -= limbs::submul_1(cur, b, bn, UINT32_MAX);
+                q[j - 1] = UINT32_MAX;
+                continue;
+            }
+            // the top three limbs give the quotient limb, only the lower bn - 2 are left to subtract
+            uint64_t rem;
+            uint32_t qhat = div_3by2(rem, cur[bn], cur[bn - 1], cur[bn - 2], top, v);
+            uint32_t borrow = bn > 2 ? limbs::submul_1(cur, b, bn - 2, qhat) : 0;
+            bool negative = rem < borrow;
+            rem -= borrow;
+            cur[bn - 2] = static_cast<uint32_t>(rem);
+            cur[bn - 1] = static_cast<uint32_t>(rem >> 32U);
+            cur[bn] = 0;
+            if (negative) {
+                --qhat;
+                limbs::add_n(cur, cur, b, bn);
+            }
+            q[j - 1] = qhat;
+        }
+    }
+
+    void div_3n_2n(uint32_t* q, uint32_t* a, uint32_t const* b, size_t h);
+
+    // a[0..2n) / b[0..n), a < b * B^n, b normalized: quotient to q[0..n), remainder to a[0..n)
+    void div_2n_1n(uint32_t* q, uint32_t* a, uint32_t const* b, size_t n) {
+        if (n % 2 != 0 || n < BZ_THRESHOLD) {
+            divrem_basecase(q, a, 2 * n, b, n, limbs::invert_2(b[n - 1], b[n - 2]));
+            return;
+        }
+        size_t h = n / 2;
+        div_3n_2n(q + h, a + h, b, h);
+        div_3n_2n(q, a, b, h);
+    }
+
+    // a[0..3h) / b[0..2h), a < b * B^h, b normalized: quotient to q[0..h), remainder to a[0..2h)
+    void div_3n_2n(uint32_t* q, uint32_t* a, uint32_t const* b, size_t h) {
+        uint32_t const* b1 = b + h;
+        if (limbs::cmp(a + 2 * h, b1, h) < 0) {
+            div_2n_1n(q, a + h, b1, h);
+        } else {
+            // the top half of a equals b1, so the estimate is B^h - 1 with remainder a1 + b1
+            std::fill(q, q + h, UINT32_MAX);
+            std::fill(a + 2 * h, a + 3 * h, 0);
+            limbs::add(a + h, a + h, 2 * h, b1, h);
+        }
+        buffer d(2 * h);
+        limbs::mul(d.data(), q, h, b, h);
+        uint32_t borrow = limbs::sub(a, a, 3 * h, d.data(), 2 * h);
+        uint32_t const one = 1;
+        while (borrow != 0) {
+            limbs::sub(q, q, h, &one, 1);
+            borrow -= limbs::add(a, a, 3 * h, b, 2 * h);
+        }
+    }
+
+    // Burnikel-Ziegler: the divisor is padded to n = j * 2^k limbs and the dividend is consumed in n-limb blocks
+    void divrem_bz(uint32_t* q, uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        size_t m = 1;
+        while (m * BZ_THRESHOLD < bn) {
+            m <<= 1U;
+        }
+        size_t n = (bn + m - 1) / m * m;
+        size_t limb_shift = n - bn;
+        uint32_t bit_shift = __builtin_clz(b[bn - 1]);
+        buffer nb(n, 0);
+        limbs::lshift(nb.data() + limb_shift, b, bn, bit_shift);
+
+        size_t t = std::max<size_t>(2, (an + limb_shift + 1 + n) / n);
+        buffer u(t * n, 0);
+        u[an + limb_shift] = limbs::lshift(u.data() + limb_shift, a, an, bit_shift);
+        buffer quotient((t - 1) * n);
+        for (size_t i = t - 1; i > 0; --i) {
+            div_2n_1n(quotient.data() + (i - 1) * n, u.data() + (i - 1) * n, nb.data(), n);
+        }
+        std::copy(quotient.begin(), quotient.begin() + (an - bn + 1), q);
+        limbs::rshift(r, u.data() + limb_shift, bn, bit_shift);
+    }
+
+    bool not_less(uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        an = normalized_size(a, an);
+        if (an != bn) {
+            return an > bn;
+        }
+        return limbs::cmp(a, b, bn) >= 0;
+    }
+
+    // v[0..n] = floor((B^2n - 1) / b), b[0..n) normalized; one Newton step per halving of n
+    void reciprocal(uint32_t* v, uint32_t const* b, size_t n) {
+        uint32_t const one = 1;
+        if (n < NEWTON_THRESHOLD) {
+            buffer u(2 * n, UINT32_MAX);
+            buffer rem(n);
+            limbs::divrem(v, rem.data(), u.data(), 2 * n, b, n);
+            return;
+        }
+        size_t h = (n + 1) / 2;
+        size_t low = n - h;
+        buffer vh(h + 1);
+        reciprocal(vh.data(), b + low, h);
+
+        // x = vh * B^low approximates B^2n / b to about h limbs; e = B^2n - b * x
+        buffer x(n + 1, 0);
+        std::copy(vh.begin(), vh.end(), x.begin() + low);
+        buffer e(2 * n + 1);
+        limbs::mul(e.data(), b, n, x.data(), n + 1);
+        bool negative = e[2 * n] != 0;
+        if (negative) {
+            e[2 * n] -= 1;
+        } else {
+            for (size_t i = 0; i < 2 * n; ++i) {
+                e[i] = ~e[i];
+            }
+            limbs::add(e.data(), e.data(), 2 * n, &one, 1);
+        }
+
+        // x += x * e / B^2n, with the low n - 2 limbs of e dropped
+        size_t skip = n - 2;
+        size_t en = normalized_size(e.data(), e.size());
+        if (en > skip) {
+            buffer prod(h + 1 + en - skip);
+            limbs::mul(prod.data(), vh.data(), h + 1, e.data() + skip, en - skip);
+            size_t offset = h + 2;
+            if (prod.size() > offset) {
+                size_t dn = normalized_size(prod.data() + offset, prod.size() - offset);
+                if (negative) {
+                    limbs::sub(x.data(), x.data(), n + 1, prod.data() + offset, dn);
+                } else {
+                    limbs::add(x.data(), x.data(), n + 1, prod.data() + offset, dn);
+                }
+            }
+        }
+
+        // fix the last few units so that 0 <= B^2n - 1 - b * x < b
+        buffer bx(2 * n + 1);
+        limbs::mul(bx.data(), b, n, x.data(), n + 1);
+        while (bx[2 * n] != 0) {
+            limbs::sub(x.data(), x.data(), n + 1, &one, 1);
+            limbs::sub(bx.data(), bx.data(), 2 * n + 1, b, n);
+        }
+        for (size_t i = 0; i < 2 * n; ++i) {
+            bx[i] = ~bx[i];
+        }
+        while (not_less(bx.data(), 2 * n, b, n)) {
+            limbs::add(x.data(), x.data(), n + 1, &one, 1);
+            limbs::sub(bx.data(), bx.data(), 2 * n, b, n);
+        }
+        std::copy(x.begin(), x.end(), v);
+    }
+
+    // Division by a precomputed reciprocal: each n-limb block costs two multiplications and a few corrections
+    void divrem_newton(uint32_t* q, uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t n) {
+        uint32_t const one = 1;
+        uint32_t bit_shift = __builtin_clz(b[n - 1]);
+        buffer nb(n);
+        limbs::lshift(nb.data(), b, n, bit_shift);
+        buffer v(n + 1);
+        reciprocal(v.data(), nb.data(), n);
+
+        size_t t = std::max<size_t>(2, (an + 1 + n) / n);
+        buffer u(t * n, 0);
+        u[an] = limbs::lshift(u.data(), a, an, bit_shift);
+        buffer quotient((t - 1) * n);
+        buffer prod(2 * n + 1);
+        for (size_t i = t - 1; i > 0; --i) {
+            uint32_t* z = u.data() + (i - 1) * n;
+            uint32_t* qe = quotient.data() + (i - 1) * n;
+            limbs::mul(prod.data(), z + n, n, v.data(), n + 1);
+            std::copy(prod.begin() + n, prod.begin() + 2 * n, qe);
+            limbs::mul(prod.data(), qe, n, nb.data(), n);
+            limbs::sub(z, z, 2 * n, prod.data(), 2 * n);
+            while (not_less(z, 2 * n, nb.data(), n)) {
+                limbs::add(qe, qe, n, &one, 1);
+                limbs::sub(z, z, 2 * n, nb.data(), n);
+            }
+        }
+        std::copy(quotient.begin(), quotient.begin() + (an - n + 1), q);
+        limbs::rshift(r, u.data(), n, bit_shift);
+    }
+}
+
+namespace limbs {
+    uint32_t add_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n) {
+#ifdef BIG_INTEGER_ASM
+        uint64_t carry = add_long_long(as_qwords(r), as_qwords(a), as_qwords(b), n / 2);
+        if (n % 2 != 0) {
+            carry += static_cast<uint64_t>(a[n - 1]) + b[n - 1];
+            r[n - 1] = static_cast<uint32_t>(carry);
+            carry >>= 32U;
+        }
+        return static_cast<uint32_t>(carry);
+#else
+        unsigned char carry = 0;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            uint64_t x0 = add_carry(load_2(a + i), load_2(b + i), carry);
+            uint64_t x1 = add_carry(load_2(a + i + 2), load_2(b + i + 2), carry);
+            store_2(r + i, x0);
+            store_2(r + i + 2, x1);
+        }
+        if (i + 2 <= n) {
+            store_2(r + i, add_carry(load_2(a + i), load_2(b + i), carry));
+            i += 2;
+        }
+        if (i < n) {
+            uint64_t sum = static_cast<uint64_t>(a[i]) + b[i] + carry;
+            r[i] = static_cast<uint32_t>(sum);
+            carry = static_cast<unsigned char>(sum >> 32U);
+        }
+        return carry;
+#endif
+    }
+
+    uint32_t add(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        uint32_t carry = add_n(r, a, b, bn);
+        size_t i = bn;
+        for (; carry != 0 && i < an; ++i) {
+            r[i] = a[i] + 1;
+            carry = r[i] == 0;
+        }
+        if (r != a) {
+            std::copy(a + i, a + an, r + i);
+        }
+        return carry;
+    }
+
+    uint32_t sub_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n) {
+#ifdef BIG_INTEGER_ASM
+        uint64_t borrow = sub_long_long(as_qwords(r), as_qwords(a), as_qwords(b), n / 2);
+        if (n % 2 != 0) {
+            uint64_t diff = static_cast<uint64_t>(a[n - 1]) - b[n - 1] - borrow;
+            r[n - 1] = static_cast<uint32_t>(diff);
+            borrow = diff >> 63U;
+        }
+        return static_cast<uint32_t>(borrow);
+#else
+        unsigned char borrow = 0;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            uint64_t x0 = sub_borrow(load_2(a + i), load_2(b + i), borrow);
+            uint64_t x1 = sub_borrow(load_2(a + i + 2), load_2(b + i + 2), borrow);
+            store_2(r + i, x0);
+            store_2(r + i + 2, x1);
+        }
+        if (i + 2 <= n) {
+            store_2(r + i, sub_borrow(load_2(a + i), load_2(b + i), borrow));
+            i += 2;
+        }
+        if (i < n) {
+            uint64_t diff = static_cast<uint64_t>(a[i]) - b[i] - borrow;
+            r[i] = static_cast<uint32_t>(diff);
+            borrow = static_cast<unsigned char>(diff >> 63U);
+        }
+        return borrow;
+#endif
+    }
+
+    uint32_t sub(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        uint32_t borrow = sub_n(r, a, b, bn);
+        size_t i = bn;
+        for (; borrow != 0 && i < an; ++i) {
+            borrow = a[i] == 0;
+            r[i] = a[i] - 1;
+        }
+        if (r != a) {
+            std::copy(a + i, a + an, r + i);
+        }
+        return borrow;
+    }
+
+    int32_t cmp(uint32_t const* a, uint32_t const* b, size_t n) {
+        for (size_t i = n; i > 0; --i) {
+            if (a[i - 1] != b[i - 1]) {
+                return a[i - 1] < b[i - 1] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    uint32_t mul_1(uint32_t* r, uint32_t const* a, size_t n, uint32_t b) {
+#ifdef BIG_INTEGER_ASM
+        uint64_t carry = mul_long_short(as_qwords(r), as_qwords(a), n / 2, b);
+        if (n % 2 != 0) {
+            carry += static_cast<uint64_t>(a[n - 1]) * b;
+            r[n - 1] = static_cast<uint32_t>(carry);
+            carry >>= 32U;
+        }
+        return static_cast<uint32_t>(carry);
+#else
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            carry += static_cast<uint64_t>(a[i]) * b;
+            r[i] = static_cast<uint32_t>(carry);
+            carry >>= 32U;
+        }
+        return static_cast<uint32_t>(carry);
+#endif
+    }
+
+    uint32_t addmul_1(uint32_t* r, uint32_t const* a, size_t n, uint32_t b) {
+#ifdef BIG_INTEGER_ASM
+        uint64_t carry = add_mul_long_short(as_qwords(r), as_qwords(a), n / 2, b);
+        if (n % 2 != 0) {
+            carry += static_cast<uint64_t>(a[n - 1]) * b + r[n - 1];
+            r[n - 1] = static_cast<uint32_t>(carry);
+            carry >>= 32U;
+        }
+        return static_cast<uint32_t>(carry);
+#else
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            carry += static_cast<uint64_t>(a[i]) * b + r[i];
+            r[i] = static_cast<uint32_t>(carry);
+            carry >>= 32U;
+        }
+        return static_cast<uint32_t>(carry);
+#endif
+    }
+
+    uint32_t submul_1(uint32_t* r, uint32_t const* a, size_t n, uint32_t b) {
+#ifdef BIG_INTEGER_ASM
+        uint64_t borrow = sub_mul_long_short(as_qwords(r), as_qwords(a), n / 2, b);
+        if (n % 2 != 0) {
+            uint64_t prod = static_cast<uint64_t>(a[n - 1]) * b + borrow;
+            uint32_t low = static_cast<uint32_t>(prod);
+            borrow = (prod >> 32U) + (r[n - 1] < low);
+            r[n - 1] -= low;
+        }
+        return static_cast<uint32_t>(borrow);
+#else
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t prod = static_cast<uint64_t>(a[i]) * b + borrow;
+            uint32_t low = static_cast<uint32_t>(prod);
+            borrow = (prod >> 32U) + (r[i] < low);
+            r[i] -= low;
+        }
+        return static_cast<uint32_t>(borrow);
+#endif
+    }
+
+    void and_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n) {
+        bitwise_n(r, a, b, n, and_op());
+    }
+
+    void ior_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n) {
+        bitwise_n(r, a, b, n, ior_op());
+    }
+
+    void xor_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n) {
+        bitwise_n(r, a, b, n, xor_op());
+    }
+
+    void andn_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n) {
+        bitwise_n(r, a, b, n, andn_op());
+    }
+
+    uint32_t lshift(uint32_t* r, uint32_t const* a, size_t n, uint32_t cnt) {
+        if (cnt == 0) {
+            std::copy_backward(a, a + n, r + n);
+            return 0;
+        }
+        uint32_t out = a[n - 1] >> (32U - cnt);
+        for (size_t i = n - 1; i > 0; --i) {
+            r[i] = (a[i] << cnt) | (a[i - 1] >> (32U - cnt));
+        }
+        r[0] = a[0] << cnt;
+        return out;
+    }
+
+    uint32_t rshift(uint32_t* r, uint32_t const* a, size_t n, uint32_t cnt) {
+        if (cnt == 0) {
+            std::copy(a, a + n, r);
+            return 0;
+        }
+        uint32_t out = a[0] << (32U - cnt);
+        for (size_t i = 0; i + 1 < n; ++i) {
+            r[i] = (a[i] >> cnt) | (a[i + 1] << (32U - cnt));
+        }
+        r[n - 1] = a[n - 1] >> cnt;
+        return out;
+    }
+
+    void mul(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        if (an < bn) {
+            std::swap(a, b);
+            std::swap(an, bn);
+        }
+        size_t n = an + bn;
+        an = normalized_size(a, an);
+        bn = normalized_size(b, bn);
+        if (bn == 0) {
+            std::fill(r, r + n, 0);
+            return;
+        }
+        if (an < bn) {
+            std::swap(a, b);
+            std::swap(an, bn);
+        }
+        mul_rec(r, a, an, b, bn);
+        std::fill(r + an + bn, r + n, 0);
+    }
+
+    void sqr(uint32_t* r, uint32_t const* a, size_t n) {
+        size_t len = normalized_size(a, n);
+        if (len == 0) {
+            std::fill(r, r + 2 * n, 0);
+            return;
+        }
+        mul_rec(r, a, len, a, len);
+        std::fill(r + 2 * len, r + 2 * n, 0);
+    }
+
+    uint32_t addmul(uint32_t* r, size_t rn, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        if (an < bn) {
+            std::swap(a, b);
+            std::swap(an, bn);
+        }
+        if (bn >= KARATSUBA_THRESHOLD) {
+            buffer prod(an + bn);
+            mul(prod.data(), a, an, b, bn);
+            return add(r, r, rn, prod.data(), an + bn);
+        }
+        // below Karatsuba the rows of the schoolbook product go straight into r
+        uint32_t const one = 1;
+        uint32_t carry = 0;
+        for (size_t j = 0; j < bn; ++j) {
+            uint32_t high = addmul_1(r + j, a, an, b[j]);
+            uint32_t* top = r + j + an;
+            *top += high;
+            if (*top < high) {
+                size_t rest = rn - j - an - 1;
+                carry += rest == 0 ? 1 : add(top + 1, top + 1, rest, &one, 1);
+            }
+        }
+        return carry;
+    }
+
+    uint32_t submul(uint32_t* r, size_t rn, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        if (an < bn) {
+            std::swap(a, b);
+            std::swap(an, bn);
+        }
+        if (bn >= KARATSUBA_THRESHOLD) {
+            buffer prod(an + bn);
+            mul(prod.data(), a, an, b, bn);
+            return sub(r, r, rn, prod.data(), an + bn);
+        }
+        uint32_t const one = 1;
+        uint32_t borrow = 0;
+        for (size_t j = 0; j < bn; ++j) {
+            uint32_t high = submul_1(r + j, a, an, b[j]);
+            uint32_t* top = r + j + an;
+            bool under = *top < high;
+            *top -= high;
+            if (under) {
+                size_t rest = rn - j - an - 1;
+                borrow += rest == 0 ? 1 : sub(top + 1, top + 1, rest, &one, 1);
+            }
+        }
+        return borrow;
+    }
+
+    uint32_t divrem_1(uint32_t* q, uint32_t const* a, size_t n, uint32_t d) {
+#ifdef BIG_INTEGER_ASM
+        uint64_t rem = 0;
+        if (n % 2 != 0) {
+            rem = a[n - 1] % d;
+            q[n - 1] = a[n - 1] / d;
+        }
+        return static_cast<uint32_t>(div_long_short(as_qwords(q), as_qwords(a), n / 2, d, rem));
+#else
+        if (n >= DIVREM_1_PREINV_THRESHOLD) {
+            uint32_t shift = __builtin_clz(d);
+            return divrem_1_preinv(q, a, n, d << shift, shift, invert_1(d << shift));
+        }
+        uint64_t rest = 0;
+        for (size_t i = n; i > 0; --i) {
+            uint64_t cur = (rest << 32U) | a[i - 1];
+            q[i - 1] = static_cast<uint32_t>(cur / d);
+            rest = cur % d;
+        }
+        return static_cast<uint32_t>(rest);
+#endif
+    }
+
+    void divrem(uint32_t* q, uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn) {
+        if (bn == 1) {
+            r[0] = divrem_1(q, a, an, b[0]);
+            return;
+        }
+        size_t qn = an - bn + 1;
+        if (bn >= NEWTON_THRESHOLD && qn >= NEWTON_THRESHOLD) {
+            divrem_newton(q, r, a, an, b, bn);
+        } else if (bn >= BZ_THRESHOLD && qn >= BZ_THRESHOLD) {
+            divrem_bz(q, r, a, an, b, bn);
+        } else {
+            uint32_t bit_shift = __builtin_clz(b[bn - 1]);
+            buffer nb(bn);
+            limbs::lshift(nb.data(), b, bn, bit_shift);
+            divrem_preinv(q, r, a, an, nb.data(), bn, bit_shift, invert_2(nb[bn - 1], nb[bn - 2]));
+        }
+    }
+
+    uint32_t invert_1(uint32_t d) {
+        return static_cast<uint32_t>(((static_cast<uint64_t>(~d) << 32U) | UINT32_MAX) / d);
+    }
+
+    uint32_t negative_inverse(uint32_t m) {
+        // each Newton step doubles the correct low bits of m^-1, starting from 3
+        uint32_t x = m;
+        for (int i = 0; i < 4; ++i) {
+            x *= 2 - m * x;
+        }
+        return -x;
+    }
+
+    uint32_t invert_2(uint32_t d1, uint32_t d0) {
+        // start from the reciprocal of d1 and account for d0 (Moller-Granlund, Algorithm 6)
+        uint32_t v = invert_1(d1);
+        uint32_t p = d1 * v + d0;
+        if (p < d0) {
+            --v;
+            if (p >= d1) {
+                --v;
+                p -= d1;
+            }
+            p -= d1;
+        }
+        uint64_t t = static_cast<uint64_t>(v) * d0;
+        uint32_t t1 = static_cast<uint32_t>(t >> 32U);
+        p += t1;
+        if (p < t1) {
+            --v;
+            if (p >= d1 && (p > d1 || static_cast<uint32_t>(t) >= d0)) {
+                --v;
+            }
+        }
+        return v;
+    }
+
+    uint32_t divrem_1_preinv(uint32_t* q, uint32_t const* a, size_t n, uint32_t d, uint32_t shift, uint32_t v) {
+        if (n == 0) {
+            return 0;
+        }
+        uint32_t rest = 0;
+        if (shift == 0) {
+            for (size_t i = n; i > 0; --i) {
+                q[i - 1] = div_2by1(rest, rest, a[i - 1], d, v);
+            }
+            return rest;
+        }
+        // a is shifted on the fly: a[i] contributes its low bits to limb i and its high bits to limb i + 1
+        rest = a[n - 1] >> (32U - shift);
+        for (size_t i = n - 1; i > 0; --i) {
+            uint32_t u0 = (a[i] << shift) | (a[i - 1] >> (32U - shift));
+            q[i] = div_2by1(rest, rest, u0, d, v);
+        }
+        q[0] = div_2by1(rest, rest, a[0] << shift, d, v);
+        return rest >> shift;
+    }
+
+    void divrem_preinv(uint32_t* q, uint32_t* r, uint32_t const* a, size_t an,
+                       uint32_t const* d, size_t dn, uint32_t shift, uint32_t v) {
+        size_t qn = an - dn + 1;
+        if (dn >= BZ_THRESHOLD && qn >= BZ_THRESHOLD) {
+            // the recursive algorithms normalize on their own
+            buffer b(dn);
+            limbs::rshift(b.data(), d, dn, shift);
+            divrem(q, r, a, an, b.data(), normalized_size(b.data(), dn));
+            return;
+        }
+        buffer u(an + 1);
+        u[an] = limbs::lshift(u.data(), a, an, shift);
+        divrem_basecase(q, u.data(), an + 1, d, dn, v);
+        limbs::rshift(r, u.data(), dn, shift);
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef LIMBS_H
+#define LIMBS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Low-level arithmetic on magnitudes stored as arrays of 32-bit limbs,
+// least significant limb first. Callers own all buffers; lengths are in limbs.
+namespace limbs {
+    // r = a + b, returns carry out; r may alias a or b
+    uint32_t add_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n);
+    // r[0..an) = a + b, an >= bn, returns carry out
+    uint32_t add(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn);
+
+    // r = a - b, returns borrow out; r may alias a or b
+    uint32_t sub_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n);
+    // r[0..an) = a - b, an >= bn, returns borrow out
+    uint32_t sub(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn);
+
+    // -1, 0 or 1 as a compares to b, both n limbs long
+    int32_t cmp(uint32_t const* a, uint32_t const* b, size_t n);
+
+    // r = a * b, returns high limb
+    uint32_t mul_1(uint32_t* r, uint32_t const* a, size_t n, uint32_t b);
+    // r += a * b, returns high limb
+    uint32_t addmul_1(uint32_t* r, uint32_t const* a, size_t n, uint32_t b);
+    // r -= a * b, returns high limb of the borrow
+    uint32_t submul_1(uint32_t* r, uint32_t const* a, size_t n, uint32_t b);
+
+    // r = a & b, a | b, a ^ b and a & ~b, n limbs each; r may alias a or b
+    void and_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n);
+    void ior_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n);
+    void xor_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n);
+    void andn_n(uint32_t* r, uint32_t const* a, uint32_t const* b, size_t n);
+
+    // r = a << cnt and r = a >> cnt for 0 <= cnt < 32, return the bits shifted out; r may equal a
+    uint32_t lshift(uint32_t* r, uint32_t const* a, size_t n, uint32_t cnt);
+    uint32_t rshift(uint32_t* r, uint32_t const* a, size_t n, uint32_t cnt);
+
+    // r[0..an + bn) = a * b; r must not overlap a or b
+    void mul(uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn);
+    // r[0..2n) = a * a; r must not overlap a
+    void sqr(uint32_t* r, uint32_t const* a, size_t n);
+    // r[0..rn) += a * b and r[0..rn) -= a * b for rn >= an + bn, return the carry or borrow out;
+    // r must not overlap a or b
+    uint32_t addmul(uint32_t* r, size_t rn, uint32_t const* a, size_t an, uint32_t const* b, size_t bn);
+    uint32_t submul(uint32_t* r, size_t rn, uint32_t const* a, size_t an, uint32_t const* b, size_t bn);
+
+    // q = a / d, returns a % d
+    uint32_t divrem_1(uint32_t* q, uint32_t const* a, size_t n, uint32_t d);
+    // q[0..an - bn + 1) = a / b, r[0..bn) = a % b; an >= bn, b[bn - 1] != 0, no overlaps
+    void divrem(uint32_t* q, uint32_t* r, uint32_t const* a, size_t an, uint32_t const* b, size_t bn);
+
+    // Moller-Granlund reciprocals of a normalized divisor (top bit set):
+    // floor((B^2 - 1) / d) - B and floor((B^3 - 1) / (d1 * B + d0)) - B
+    uint32_t invert_1(uint32_t d);
+    uint32_t invert_2(uint32_t d1, uint32_t d0);
+    // -m^-1 mod B for odd m, the Montgomery REDC factor
+    uint32_t negative_inverse(uint32_t m);
+    // divrem_1 by d >> shift, where d is normalized and v = invert_1(d); q may equal a
+    uint32_t divrem_1_preinv(uint32_t* q, uint32_t const* a, size_t n, uint32_t d, uint32_t shift, uint32_t v);
+    // divrem by d >> shift, where d[0..dn) is normalized, dn >= 2 and v = invert_2(d[dn - 1], d[dn - 2])
+    void divrem_preinv(uint32_t* q, uint32_t* r, uint32_t const* a, size_t an,
+                       uint32_t const* d, size_t dn, uint32_t shift, uint32_t v);
+}
+
+#endif // LIMBS_H
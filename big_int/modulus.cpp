@@ -0,0 +1,202 @@
+#include "modulus.h"
+#include "limbs.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    // Exponent lengths (in bits) up to which windows of 1, 2, ... bits are used.
+    size_t const WINDOW_THRESHOLDS[] = {7, 36, 140, 450, 1303, 3529};
+
+    size_t window_size(size_t bits) {
+        size_t k = 1;
+        for (size_t limit : WINDOW_THRESHOLDS) {
+            if (bits <= limit) {
+                return k;
+            }
+            ++k;
+        }
+        return k;
+    }
+}
+
+modulus_context::modulus_context(big_integer const& m) : m(m), n(m.size()), mod(m.words.begin(), m.words.end()), inv(0) {
+    if (m.sign <= 0) {
+        throw std::runtime_error("Invalid modulus");
+    }
+    // one division gives both the Barrett factor and R^2 mod m for the Montgomery conversions
+    std::vector<uint32_t> power(2 * n + 1, 0);
+    power[2 * n] = 1;
+    mu.resize(n + 2);
+    r2.resize(n);
+    limbs::divrem(mu.data(), r2.data(), power.data(), power.size(), mod.data(), n);
+    while (mu.back() == 0) {
+        mu.pop_back();
+    }
+    montgomery = (mod[0] & 1U) != 0;
+    if (montgomery) {
+        inv = limbs::negative_inverse(mod[0]);
+    }
+}
+
+big_integer const& modulus_context::value() const {
+    return m;
+}
+
+big_integer modulus_context::from_limbs(uint32_t const* a, size_t n) {
+    while (n > 0 && a[n - 1] == 0) {
+        --n;
+    }
+    return big_integer::from_words(1, storage(a, a + n));
+}
+
+void modulus_context::reduce_barrett(uint32_t* r, uint32_t const* x, size_t xn, uint32_t* work) const {
+    if (xn < n) {
+        std::copy(x, x + xn, r);
+        std::fill(r + xn, r + n, 0);
+        return;
+    }
+    // q = floor(floor(x / B^(n-1)) * mu / B^(n+1)) is at most two short of x / m
+    size_t qn = xn - (n - 1);
+    uint32_t* q = work;
+    limbs::mul(q, x + n - 1, qn, mu.data(), mu.size());
+    size_t q3n = qn + mu.size() - std::min(qn + mu.size(), n + 1);
+    uint32_t* prod = q + qn + mu.size();
+    uint32_t* t = prod + q3n + n;
+    std::copy(x, x + std::min(xn, n + 1), t);
+    std::fill(t + std::min(xn, n + 1), t + n + 1, 0);
+    if (q3n != 0) {
+        limbs::mul(prod, q + n + 1, q3n, mod.data(), n);
+        limbs::sub_n(t, t, prod, n + 1);
+    }
+    while (t[n] != 0 || limbs::cmp(t, mod.data(), n) >= 0) {
+        limbs::sub(t, t, n + 1, mod.data(), n);
+    }
+    std::copy(t, t + n, r);
+}
+
+void modulus_context::redc(uint32_t* r, uint32_t* t) const {
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t carry = limbs::addmul_1(t + i, mod.data(), n, t[i] * inv);
+        limbs::add(t + i + n, t + i + n, n + 1 - i, &carry, 1);
+    }
+    if (t[2 * n] != 0 || limbs::cmp(t + n, mod.data(), n) >= 0) {
+        limbs::sub_n(r, t + n, mod.data(), n);
+    } else {
+        std::copy(t + n, t + 2 * n, r);
+    }
+}
+
+void modulus_context::mul_form(uint32_t* r, uint32_t const* a, uint32_t const* b, std::vector<uint32_t>& scratch) const {
+    scratch.resize(8 * n + 9);
+    uint32_t* prod = scratch.data();
+    if (a == b) {
+        limbs::sqr(prod, a, n);
+    } else {
+        limbs::mul(prod, a, n, b, n);
+    }
+    if (montgomery) {
+        prod[2 * n] = 0;
+        redc(r, prod);
+    } else {
+        reduce_barrett(r, prod, 2 * n, prod + 2 * n + 1);
+    }
+}
+
+std::vector<uint32_t> modulus_context::residue(big_integer const& a) const {
+    big_integer value = reduce(a);
+    std::vector<uint32_t> res(value.words.begin(), value.words.end());
+    res.resize(n, 0);
+    return res;
+}
+
+big_integer modulus_context::reduce(big_integer const& a) const {
+    if (a.size() > 2 * n) {
+        big_integer res = a % m;
+        return res.sign < 0 ? res + m : res;
+    }
+    std::vector<uint32_t> r(n);
+    std::vector<uint32_t> work(6 * n + 8);
+    reduce_barrett(r.data(), a.words.data(), a.size(), work.data());
+    big_integer res = from_limbs(r.data(), n);
+    return a.sign < 0 && res.sign != 0 ? m - res : res;
+}
+
+big_integer modulus_context::mul(big_integer const& a, big_integer const& b) const {
+    big_integer res = reduce(a);
+    res *= reduce(b);
+    return reduce(res);
+}
+
+big_integer modulus_context::pow(big_integer const& base, big_integer const& exp) const {
+    if (exp.sign < 0) {
+        throw std::runtime_error("Negative exponent");
+    }
+    if (n == 1 && mod[0] == 1) {
+        return big_integer();
+    }
+    if (exp.sign == 0) {
+        return big_integer(1);
+    }
+    std::vector<uint32_t> scratch;
+    std::vector<uint32_t> b = residue(base);
+    if (montgomery) {
+        mul_form(b.data(), b.data(), r2.data(), scratch);
+    }
+
+    size_t bits = 32 * exp.size() - __builtin_clz(exp.words.back());
+    size_t k = window_size(bits);
+    // odd powers b, b^3, ..., b^(2^k - 1)
+    std::vector<uint32_t> table(n << (k - 1));
+    std::copy(b.begin(), b.end(), table.begin());
+    if (k > 1) {
+        std::vector<uint32_t> b2(n);
+        mul_form(b2.data(), b.data(), b.data(), scratch);
+        for (size_t i = 1; i < (size_t(1) << (k - 1)); ++i) {
+            mul_form(&table[i * n], &table[(i - 1) * n], b2.data(), scratch);
+        }
+    }
+
+    auto bit = [&exp](size_t i) {
+        return (exp.words[i / 32] >> (i % 32)) & 1U;
+    };
+    std::vector<uint32_t> acc(n);
+    bool started = false;
+    for (size_t i = bits; i > 0;) {
+        if (bit(i - 1) == 0) {
+            mul_form(acc.data(), acc.data(), acc.data(), scratch);
+            --i;
+            continue;
+        }
+        size_t low = i > k ? i - k : 0;
+        while (bit(low) == 0) {
+            ++low;
+        }
+        size_t window = 0;
+        for (size_t j = i; j > low; --j) {
+            window = window << 1U | bit(j - 1);
+            if (started) {
+                mul_form(acc.data(), acc.data(), acc.data(), scratch);
+            }
+        }
+        uint32_t const* power = &table[(window >> 1U) * n];
+        if (started) {
+            mul_form(acc.data(), acc.data(), power, scratch);
+        } else {
+            std::copy(power, power + n, acc.begin());
+            started = true;
+        }
+        i = low;
+    }
+
+    if (montgomery) {
+        std::vector<uint32_t> t(2 * n + 1, 0);
+        std::copy(acc.begin(), acc.end(), t.begin());
+        redc(acc.data(), t.data());
+    }
+    return from_limbs(acc.data(), n);
+}
+
+big_integer powmod(big_integer const& base, big_integer const& exp, big_integer const& mod) {
+    return modulus_context(mod).pow(base, exp);
+}
@@ -0,0 +1,51 @@
+#ifndef MODULUS_H
+#define MODULUS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "big_integer.h"
+
+// Reduction data for repeated arithmetic modulo a fixed m > 0, set up once and reused for every
+// product. reduce and mul use Barrett reduction; pow works in Montgomery form when m is odd, where
+// the conversions in and out pay off over the whole exponentiation. (Not named modulus, which would
+// clash with std::modulus under using namespace std.)
+struct modulus_context {
+    explicit modulus_context(big_integer const& m);
+
+    big_integer const& value() const;
+
+    // a mod m, in [0, m)
+    big_integer reduce(big_integer const& a) const;
+    // a * b mod m
+    big_integer mul(big_integer const& a, big_integer const& b) const;
+    // base^exp mod m for exp >= 0, by sliding windows over the exponent bits
+    big_integer pow(big_integer const& base, big_integer const& exp) const;
+
+private:
+    // n limbs of a mod m
+    std::vector<uint32_t> residue(big_integer const& a) const;
+    // r = x mod m for x < B^2n, work has room for 6n + 8 limbs
+    void reduce_barrett(uint32_t* r, uint32_t const* x, size_t xn, uint32_t* work) const;
+    // r = t / B^n mod m, t has 2n + 1 limbs and is destroyed
+    void redc(uint32_t* r, uint32_t* t) const;
+    // r = a * b in the working form (Montgomery or plain residues); r may alias a or b
+    void mul_form(uint32_t* r, uint32_t const* a, uint32_t const* b, std::vector<uint32_t>& scratch) const;
+
+    static big_integer from_limbs(uint32_t const* a, size_t n);
+
+    big_integer m;
+    size_t n;
+    std::vector<uint32_t> mod;
+    // floor(B^2n / m) and B^2n mod m, B = 2^32
+    std::vector<uint32_t> mu;
+    std::vector<uint32_t> r2;
+    // -m^-1 mod B, odd m only
+    uint32_t inv;
+    bool montgomery;
+};
+
+big_integer powmod(big_integer const& base, big_integer const& exp, big_integer const& mod);
+
+#endif // MODULUS_H
@@ -0,0 +1,196 @@
+#include "parallel.h"
+#include "allocation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+    struct task {
+        explicit task(std::function<void()> const& f) : f(f), resource(installed_memory_resource()) {}
+
+        std::function<void()> const& f;
+        // memory resource of the thread that made the task, installed wherever it runs
+        std::pmr::memory_resource* resource;
+        // queued, claimed by a thread, finished
+        std::atomic<int> state{0};
+        std::exception_ptr error;
+    };
+
+    struct pool {
+        ~pool() {
+            stop();
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (std::thread& t : workers) {
+                t.join();
+            }
+            workers.clear();
+            stopping = false;
+        }
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable finished;
+        std::deque<std::shared_ptr<task>> queue;
+        std::vector<std::thread> workers;
+        bool stopping = false;
+    };
+
+    std::atomic<size_t> thread_count{1};
+
+    pool& instance() {
+        static pool p;
+        return p;
+    }
+
+    bool claim(task& t) {
+        int expected = 0;
+        return t.state.compare_exchange_strong(expected, 1);
+    }
+
+    void run(pool& p, task& t) {
+        try {
+            memory_scope scope(t.resource);
+            t.f();
+        } catch (...) {
+            t.error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(p.mutex);
+            t.state = 2;
+        }
+        p.finished.notify_all();
+    }
+
+    // the oldest task nobody has claimed yet; p.mutex is held
+    std::shared_ptr<task> pop(pool& p) {
+        while (!p.queue.empty()) {
+            std::shared_ptr<task> t = std::move(p.queue.front());
+            p.queue.pop_front();
+            if (claim(*t)) {
+                return t;
+            }
+        }
+        return nullptr;
+    }
+
+    void work(pool& p) {
+        std::unique_lock<std::mutex> lock(p.mutex);
+        while (true) {
+            p.wake.wait(lock, [&p] { return p.stopping || !p.queue.empty(); });
+            if (p.stopping) {
+                return;
+            }
+            std::shared_ptr<task> t = pop(p);
+            if (t != nullptr) {
+                lock.unlock();
+                run(p, *t);
+                lock.lock();
+            }
+        }
+    }
+
+    void split(size_t first, size_t last, size_t parts, std::function<void(size_t, size_t)> const& f) {
+        if (parts <= 1) {
+            f(first, last);
+            return;
+        }
+        size_t left = parts / 2;
+        size_t mid = first + (last - first) * left / parts;
+        parallel::invoke([&] { split(first, mid, left, f); }, [&] { split(mid, last, parts - left, f); });
+    }
+
+    void invoke_range(std::vector<std::function<void()>> const& jobs, size_t first, size_t last) {
+        if (last - first == 1) {
+            jobs[first]();
+            return;
+        }
+        size_t mid = first + (last - first) / 2;
+        parallel::invoke([&] { invoke_range(jobs, first, mid); }, [&] { invoke_range(jobs, mid, last); });
+    }
+}
+
+namespace parallel {
+    void set_threads(size_t n) {
+        if (n == 0) {
+            n = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        pool& p = instance();
+        p.stop();
+        for (size_t i = 1; i < n; ++i) {
+            p.workers.emplace_back(work, std::ref(p));
+        }
+        thread_count = n;
+    }
+
+    size_t threads() {
+        return thread_count;
+    }
+
+    void invoke(std::function<void()> const& f, std::function<void()> const& g) {
+        if (thread_count == 1) {
+            f();
+            g();
+            return;
+        }
+        pool& p = instance();
+        std::shared_ptr<task> t = std::make_shared<task>(g);
+        {
+            std::lock_guard<std::mutex> lock(p.mutex);
+            p.queue.push_back(t);
+        }
+        p.wake.notify_one();
+        std::exception_ptr error;
+        try {
+            f();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        if (claim(*t)) {
+            run(p, *t);
+        } else {
+            std::unique_lock<std::mutex> lock(p.mutex);
+            while (t->state != 2) {
+                std::shared_ptr<task> other = pop(p);
+                if (other != nullptr) {
+                    lock.unlock();
+                    run(p, *other);
+                    lock.lock();
+                } else {
+                    p.finished.wait(lock);
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        if (t->error) {
+            std::rethrow_exception(t->error);
+        }
+    }
+
+    void invoke_all(std::vector<std::function<void()>> const& jobs) {
+        if (!jobs.empty()) {
+            invoke_range(jobs, 0, jobs.size());
+        }
+    }
+
+    void for_range(size_t first, size_t last, std::function<void(size_t, size_t)> const& f) {
+        if (first >= last) {
+            return;
+        }
+        split(first, last, std::min(thread_count.load(), last - first), f);
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Opt-in parallel mode for huge operands. Multiplication spreads its independent sub-products and
+// NTT passes over a pool of worker threads, division and decimal conversion follow through their
+// products and splits. With the default of one thread everything runs on the calling thread.
+namespace parallel {
+    // n threads in total, the calling one included; 0 picks std::thread::hardware_concurrency().
+    // Must not be called while another thread is inside a big_integer operation.
+    void set_threads(size_t n);
+    size_t threads();
+
+    // runs f and g, g on a pool worker when one is free, and returns once both are done;
+    // a thread waiting for its task helps with queued ones, so nested calls cannot starve
+    void invoke(std::function<void()> const& f, std::function<void()> const& g);
+    void invoke_all(std::vector<std::function<void()>> const& jobs);
+    // f(begin, end) over [first, last) cut into at most threads() pieces
+    void for_range(size_t first, size_t last, std::function<void(size_t, size_t)> const& f);
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,192 @@
+#include "products.h"
+#include "limbs.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+    // Word products of at most this many factors are accumulated with mul_1.
+    size_t const LEAF_WORDS = 16;
+    // Largest n for which binomial sieves the primes up to n.
+    uint32_t const BINOMIAL_SIEVE_LIMIT = uint32_t(1) << 26U;
+
+    big_integer from_limbs(std::vector<uint32_t> const& v) {
+        return v.empty() ? big_integer(0) : big_integer(1, std::vector<uint32_t>(v.rbegin(), v.rend()));
+    }
+
+    // Multiplies small factors together as long as they fit in a word.
+    struct word_packer {
+        void push(uint32_t f) {
+            uint64_t p = acc * f;
+            if (p > UINT32_MAX) {
+                words.push_back(static_cast<uint32_t>(acc));
+                acc = f;
+            } else {
+                acc = p;
+            }
+        }
+
+        std::vector<uint32_t>& finish() {
+            if (acc > 1) {
+                words.push_back(static_cast<uint32_t>(acc));
+                acc = 1;
+            }
+            return words;
+        }
+
+        std::vector<uint32_t> words;
+        uint64_t acc = 1;
+    };
+
+    // the product of n nonzero words
+    big_integer product_words(uint32_t const* w, size_t n) {
+        if (n == 0) {
+            return 1;
+        }
+        if (n <= LEAF_WORDS) {
+            std::vector<uint32_t> acc(n);
+            acc[0] = w[0];
+            size_t m = 1;
+            for (size_t i = 1; i < n; ++i) {
+                uint32_t high = limbs::mul_1(acc.data(), acc.data(), m, w[i]);
+                if (high != 0) {
+                    acc[m++] = high;
+                }
+            }
+            acc.resize(m);
+            return from_limbs(acc);
+        }
+        size_t half = n / 2;
+        return product_words(w, half) * product_words(w + half, n - half);
+    }
+
+    big_integer product_range(big_integer const* f, size_t n) {
+        if (n == 0) {
+            return 1;
+        }
+        if (n == 1) {
+            return f[0];
+        }
+        size_t half = n / 2;
+        return product_range(f, half) * product_range(f + half, n - half);
+    }
+
+    // primes up to n, from a sieve over the odd numbers
+    std::vector<uint32_t> primes_up_to(uint32_t n) {
+        std::vector<uint32_t> primes;
+        if (n < 2) {
+            return primes;
+        }
+        primes.push_back(2);
+        // composite[i] stands for 2 * i + 1
+        std::vector<bool> composite(n / 2 + 1, false);
+        for (uint64_t p = 3; p <= n; p += 2) {
+            if (composite[p / 2]) {
+                continue;
+            }
+            primes.push_back(static_cast<uint32_t>(p));
+            for (uint64_t q = p * p; q <= n; q += 2 * p) {
+                composite[q / 2] = true;
+            }
+        }
+        return primes;
+    }
+
+    void add_magnitude(std::vector<uint32_t>& acc, storage const& w) {
+        uint32_t carry = limbs::add_n(acc.data(), acc.data(), w.data(), w.size());
+        for (size_t i = w.size(); carry != 0; ++i) {
+            carry = ++acc[i] == 0 ? 1 : 0;
+        }
+    }
+}
+
+big_integer product(std::vector<big_integer> const& factors) {
+    return product_range(factors.data(), factors.size());
+}
+
+big_integer sum(std::vector<big_integer> const& terms) {
+    size_t n = 0;
+    for (big_integer const& t : terms) {
+        n = std::max(n, t.words.size());
+    }
+    // fewer than 2^64 terms cannot carry past two extra words
+    std::vector<uint32_t> positive(n + 2, 0);
+    std::vector<uint32_t> negative(n + 2, 0);
+    bool has_negative = false;
+    for (big_integer const& t : terms) {
+        if (t.sign > 0) {
+            add_magnitude(positive, t.words);
+        } else if (t.sign < 0) {
+            add_magnitude(negative, t.words);
+            has_negative = true;
+        }
+    }
+    size_t pn = positive.size();
+    while (pn > 0 && positive[pn - 1] == 0) {
+        --pn;
+    }
+    positive.resize(pn);
+    big_integer res = from_limbs(positive);
+    if (has_negative) {
+        size_t nn = negative.size();
+        while (negative[nn - 1] == 0) {
+            --nn;
+        }
+        negative.resize(nn);
+        res -= from_limbs(negative);
+    }
+    return res;
+}
+
+big_integer factorial(uint32_t n) {
+    // n! = 2^(n - popcount(n)) times the odd parts of 3..n
+    word_packer odd;
+    for (uint32_t i = 3; i <= n && i != 0; ++i) {
+        uint32_t f = i >> __builtin_ctz(i);
+        if (f > 1) {
+            odd.push(f);
+        }
+    }
+    std::vector<uint32_t>& words = odd.finish();
+    return product_words(words.data(), words.size()) << static_cast<int>(n - __builtin_popcount(n));
+}
+
+big_integer binomial(uint32_t n, uint32_t k) {
+    if (k > n) {
+        return 0;
+    }
+    k = std::min(k, n - k);
+    if (k == 0) {
+        return 1;
+    }
+    word_packer factors;
+    if (n > BINOMIAL_SIEVE_LIMIT || k < n / 32) {
+        // few factors: n (n - 1) ... (n - k + 1) / k!, one exact division
+        for (uint32_t i = n - k + 1; i <= n && i != 0; ++i) {
+            factors.push(i);
+        }
+        std::vector<uint32_t>& words = factors.finish();
+        return product_words(words.data(), words.size()) / factorial(k);
+    }
+    // the exponent of p in n! / (k! (n - k)!) by Legendre's formula
+    for (uint32_t p : primes_up_to(n)) {
+        uint32_t e = 0;
+        for (uint64_t q = p; q <= n; q *= p) {
+            e += static_cast<uint32_t>(n / q - k / q - (n - k) / q);
+        }
+        for (; e > 0; --e) {
+            factors.push(p);
+        }
+    }
+    std::vector<uint32_t>& words = factors.finish();
+    return product_words(words.data(), words.size());
+}
+
+big_integer primorial(uint32_t n) {
+    word_packer factors;
+    for (uint32_t p : primes_up_to(n)) {
+        factors.push(p);
+    }
+    std::vector<uint32_t>& words = factors.finish();
+    return product_words(words.data(), words.size());
+}
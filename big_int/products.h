@@ -0,0 +1,22 @@
+#ifndef PRODUCTS_H
+#define PRODUCTS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "big_integer.h"
+
+// Products are taken over a balanced tree, so the large multiplications pair operands of similar size
+// and reach the Karatsuba, Toom and NTT tiers; factors that fit in a word are packed first.
+
+// the product of all factors, 1 for none
+big_integer product(std::vector<big_integer> const& factors);
+// the sum of all terms, accumulated in one preallocated buffer per sign
+big_integer sum(std::vector<big_integer> const& terms);
+big_integer factorial(uint32_t n);
+// n choose k, 0 for k > n; built from its prime factorization unless k is small next to n
+big_integer binomial(uint32_t n, uint32_t k);
+// the product of the primes up to n
+big_integer primorial(uint32_t n);
+
+#endif // PRODUCTS_H
@@ -0,0 +1,270 @@
+#include "roots.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    size_t bit_length(storage const& w) {
+        return w.empty() ? 0 : 32 * w.size() - __builtin_clz(w.back());
+    }
+
+    size_t bit_length(size_t v) {
+        size_t res = 0;
+        for (; v != 0; v >>= 1U) {
+            ++res;
+        }
+        return res;
+    }
+
+    uint64_t to_uint64(big_integer const& n) {
+        uint64_t res = 0;
+        for (uint32_t w : n.data()) {
+            res = (res << 32U) | w;
+        }
+        return res;
+    }
+
+    big_integer from_uint64(uint64_t v) {
+        return (big_integer(static_cast<uint32_t>(v >> 32U)) << 32) + static_cast<uint32_t>(v);
+    }
+
+    // whether x^k <= n, without overflow
+    bool power_at_most(uint64_t x, uint32_t k, uint64_t n) {
+        uint64_t p = 1;
+        for (uint32_t i = 0; i < k; ++i) {
+            if (x != 0 && p > n / x) {
+                return false;
+            }
+            p *= x;
+        }
+        return p <= n;
+    }
+
+    // floor(n^(1/k)) from a floating point estimate, corrected by at most a few steps
+    uint64_t root_64(uint64_t n, uint32_t k) {
+        if (k == 1 || n < 2) {
+            return n;
+        }
+        uint64_t x = k >= 64 ? 1 : static_cast<uint64_t>(std::pow(static_cast<double>(n), 1.0 / k));
+        while (x > 0 && !power_at_most(x, k, n)) {
+            --x;
+        }
+        while (power_at_most(x + 1, k, n)) {
+            ++x;
+        }
+        return x;
+    }
+
+    big_integer power(big_integer base, uint32_t e) {
+        big_integer res = 1;
+        for (; e != 0; e >>= 1U) {
+            if ((e & 1U) != 0) {
+                res *= base;
+            }
+            if (e > 1) {
+                base *= base;
+            }
+        }
+        return res;
+    }
+
+    // floor(n^(1/k)) for n > 0 of the given bit length, k >= 2: the root of n's top half gives a start
+    // with half the bits right, so a couple of Newton steps from above finish at each level
+    big_integer nth_root(big_integer const& n, size_t bits, uint32_t k) {
+        if (bits <= 64) {
+            return from_uint64(root_64(to_uint64(n), k));
+        }
+        if (k >= bits) {
+            return 1;
+        }
+        size_t s = (bits + k - 1) / k / 2;
+        big_integer y = nth_root(n >> static_cast<int>(k * s), bits - k * s, k);
+        big_integer x = (y + 1) << static_cast<int>(s);
+        while (true) {
+            big_integer t = (x * (k - 1) + n / power(x, k - 1)) / k;
+            if (t >= x) {
+                return x;
+            }
+            x = std::move(t);
+        }
+    }
+
+    std::vector<bool> square_residues(uint32_t m) {
+        std::vector<bool> res(m, false);
+        for (uint32_t i = 0; i < m; ++i) {
+            res[i * i % m] = true;
+        }
+        return res;
+    }
+
+    uint32_t mod_small(storage const& w, uint32_t m) {
+        uint64_t r = 0;
+        for (size_t i = w.size(); i > 0; --i) {
+            r = ((r << 32U) | w[i - 1]) % m;
+        }
+        return static_cast<uint32_t>(r);
+    }
+
+    bool is_prime(size_t k) {
+        for (size_t d = 2; d * d <= k; ++d) {
+            if (k % d == 0) {
+                return false;
+            }
+        }
+        return k >= 2;
+    }
+
+    size_t trailing_zeros(storage const& w) {
+        size_t i = 0;
+        while (w[i] == 0) {
+            ++i;
+        }
+        return 32 * i + __builtin_ctz(w[i]);
+    }
+
+    // largest prime below 2^32, for a cheap check of r^k = m before the full power
+    uint32_t const CHECK_PRIME = 4294967291U;
+
+    uint32_t power_mod(uint64_t x, size_t k, uint32_t p) {
+        uint64_t res = 1;
+        for (; k != 0; k >>= 1U) {
+            if ((k & 1U) != 0) {
+                res = res * x % p;
+            }
+            x = x * x % p;
+        }
+        return static_cast<uint32_t>(res);
+    }
+
+    big_integer power_low(big_integer base, uint32_t e, big_integer const& mask) {
+        big_integer res = 1;
+        for (; e != 0; e >>= 1U) {
+            if ((e & 1U) != 0) {
+                res = (res * base) & mask;
+            }
+            if (e > 1) {
+                base = (base * base) & mask;
+            }
+        }
+        return res;
+    }
+
+    // a^-1 mod 2^bits for odd a: y(2 - ay) doubles the correct low bits
+    big_integer inverse_low(big_integer const& a, size_t bits) {
+        big_integer y = 1;
+        for (size_t e = 1; e < bits;) {
+            e = std::min(2 * e, bits);
+            big_integer mask = (big_integer(1) << static_cast<int>(e)) - 1;
+            y = (y * (2 - ((a & mask) * y))) & mask;
+        }
+        return y;
+    }
+
+    // the x < 2^bits with x^k = m mod 2^bits, for odd m and odd k: the derivative k x^(k-1) is odd,
+    // so Newton steps on x^k - m double the correct low bits from x = 1
+    big_integer root_low(big_integer const& m, uint32_t k, size_t bits) {
+        big_integer x = 1;
+        for (size_t e = 1; e < bits;) {
+            e = std::min(2 * e, bits);
+            big_integer mask = (big_integer(1) << static_cast<int>(e)) - 1;
+            big_integer p = power_low(x, k - 1, mask);
+            big_integer f = (p * x - m) & mask;
+            x = (x - f * inverse_low(p * k, e)) & mask;
+        }
+        return x;
+    }
+}
+
+big_integer isqrt(big_integer const& n) {
+    if (n.sign < 0) {
+        throw std::runtime_error("Square root of a negative number");
+    }
+    size_t bits = bit_length(n.words);
+    if (bits <= 64) {
+        return from_uint64(root_64(to_uint64(n), 2));
+    }
+    // each pass doubles the correct bits of a, the root of n's top 2d bits (the isqrt of CPython)
+    size_t c = (bits - 1) / 2;
+    big_integer a = 1;
+    size_t d = 0;
+    for (size_t s = bit_length(c); s > 0; --s) {
+        size_t e = d;
+        d = c >> (s - 1);
+        a = (a << static_cast<int>(d - e - 1)) + (n >> static_cast<int>(2 * c - e - d + 1)) / a;
+    }
+    return a * a > n ? a - 1 : a;
+}
+
+big_integer iroot(big_integer const& n, int k) {
+    if (k <= 0) {
+        throw std::runtime_error("Invalid root degree");
+    }
+    if (n.sign < 0) {
+        if (k % 2 == 0) {
+            throw std::runtime_error("Even root of a negative number");
+        }
+        return -iroot(-n, k);
+    }
+    if (k == 1 || n.sign == 0) {
+        return n;
+    }
+    if (k == 2) {
+        return isqrt(n);
+    }
+    return nth_root(n, bit_length(n.words), k);
+}
+
+bool is_square(big_integer const& n) {
+    static std::vector<bool> const mod64 = square_residues(64);
+    static std::vector<bool> const mod63 = square_residues(63);
+    static std::vector<bool> const mod65 = square_residues(65);
+    static std::vector<bool> const mod11 = square_residues(11);
+    if (n.sign <= 0) {
+        return n.sign == 0;
+    }
+    if (!mod64[n.words[0] % 64]) {
+        return false;
+    }
+    uint32_t r = mod_small(n.words, 63 * 65 * 11);
+    if (!mod63[r % 63] || !mod65[r % 65] || !mod11[r % 11]) {
+        return false;
+    }
+    big_integer root = isqrt(n);
+    return root * root == n;
+}
+
+bool is_perfect_power(big_integer const& n) {
+    if (n.sign == 0 || (n.words.size() == 1 && n.words[0] == 1)) {
+        return true;
+    }
+    big_integer abs = n.sign < 0 ? -n : n;
+    // n = 2^zeros * m with m odd; in r^k both zeros and m are k-th powers' parts
+    size_t zeros = trailing_zeros(n.words);
+    big_integer m = abs >> static_cast<int>(zeros);
+    size_t bits = bit_length(m.words);
+    uint32_t m_mod = mod_small(m.words, CHECK_PRIME);
+    size_t last = bits > 1 ? bits : zeros;
+    for (size_t k = 2; k <= last; ++k) {
+        if (!is_prime(k) || (zeros != 0 && zeros % k != 0) || (k == 2 && n.sign < 0)) {
+            continue;
+        }
+        if (bits == 1) {
+            return true;
+        }
+        if (k == 2) {
+            if (is_square(m)) {
+                return true;
+            }
+            continue;
+        }
+        // an odd k-th root of m is fixed by its low bits, so it is the one candidate
+        big_integer r = root_low(m, static_cast<uint32_t>(k), (bits + k - 1) / k);
+        if (power_mod(mod_small(r.words, CHECK_PRIME), k, CHECK_PRIME) == m_mod
+                && power(r, static_cast<uint32_t>(k)) == m) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,15 @@
+#ifndef ROOTS_H
+#define ROOTS_H
+
+#include "big_integer.h"
+
+// floor(sqrt(n)) for n >= 0
+big_integer isqrt(big_integer const& n);
+// the k-th root of n truncated toward zero, k >= 1; n may be negative for odd k
+big_integer iroot(big_integer const& n, int k);
+// whether n = r * r for some integer r; square residues mod 64, 63, 65 and 11 reject most n before any root is taken
+bool is_square(big_integer const& n);
+// whether n = r^k for some integer r and k >= 2, counting 0, 1 and -1
+bool is_perfect_power(big_integer const& n);
+
+#endif // ROOTS_H
@@ -0,0 +1,205 @@
+#include "storage.h"
+#include "allocation.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+// Heap words are preceded by the resource they were taken from, null for the global heap.
+static size_t const HEADER_SIZE = alignof(std::max_align_t);
+
+static uint32_t* allocate(size_t n) {
+    std::pmr::memory_resource* resource = installed_memory_resource();
+    size_t bytes = HEADER_SIZE + n * sizeof(uint32_t);
+    char* block = static_cast<char*>(resource == nullptr ? operator new(bytes) : resource->allocate(bytes, HEADER_SIZE));
+    std::memcpy(block, &resource, sizeof(resource));
+    return reinterpret_cast<uint32_t*>(block + HEADER_SIZE);
+}
+
+static void deallocate(uint32_t* words, size_t n) {
+    char* block = reinterpret_cast<char*>(words) - HEADER_SIZE;
+    std::pmr::memory_resource* resource;
+    std::memcpy(&resource, block, sizeof(resource));
+    if (resource == nullptr) {
+        operator delete(block);
+    } else {
+        resource->deallocate(block, HEADER_SIZE + n * sizeof(uint32_t), HEADER_SIZE);
+    }
+}
+
+storage::storage() : size_(0), capacity_(INLINE_CAPACITY) {}
+
+storage::storage(size_t n, uint32_t value) : storage() {
+    resize(n, value);
+}
+
+storage::storage(uint32_t const* first, uint32_t const* last) : storage() {
+    size_t n = last - first;
+    reserve(n);
+    std::copy(first, last, data());
+    size_ = n;
+}
+
+storage::storage(storage const& other) : storage(other.begin(), other.end()) {}
+
+storage::storage(storage&& other) noexcept : size_(other.size_), capacity_(other.capacity_) {
+    if (other.is_small()) {
+        std::copy(other.small_, other.small_ + other.size_, small_);
+    } else {
+        heap_ = other.heap_;
+        other.capacity_ = INLINE_CAPACITY;
+    }
+    other.size_ = 0;
+}
+
+storage& storage::operator=(storage const& other) {
+    if (this != &other) {
+        if (other.size_ > capacity_) {
+            storage tmp(other);
+            swap(tmp);
+        } else {
+            std::copy(other.begin(), other.end(), data());
+            size_ = other.size_;
+        }
+    }
+    return *this;
+}
+
+storage& storage::operator=(storage&& other) noexcept {
+    if (this != &other) {
+        release();
+        new (this) storage(std::move(other));
+    }
+    return *this;
+}
+
+storage::~storage() {
+    release();
+}
+
+bool storage::is_small() const {
+    return capacity_ == INLINE_CAPACITY;
+}
+
+void storage::release() {
+    if (!is_small()) {
+        deallocate(heap_, capacity_);
+        capacity_ = INLINE_CAPACITY;
+    }
+    size_ = 0;
+}
+
+uint32_t& storage::operator[](size_t i) {
+    return data()[i];
+}
+
+uint32_t const& storage::operator[](size_t i) const {
+    return data()[i];
+}
+
+uint32_t* storage::data() {
+    return is_small() ? small_ : heap_;
+}
+
+uint32_t const* storage::data() const {
+    return is_small() ? small_ : heap_;
+}
+
+size_t storage::size() const {
+    return size_;
+}
+
+size_t storage::capacity() const {
+    return capacity_;
+}
+
+bool storage::empty() const {
+    return size_ == 0;
+}
+
+uint32_t& storage::back() {
+    return data()[size_ - 1];
+}
+
+uint32_t const& storage::back() const {
+    return data()[size_ - 1];
+}
+
+void storage::push_back(uint32_t value) {
+    if (size_ == capacity_) {
+        reserve(2 * capacity_);
+    }
+    data()[size_++] = value;
+}
+
+void storage::pop_back() {
+    --size_;
+}
+
+void storage::resize(size_t n, uint32_t value) {
+    if (n > capacity_) {
+        reserve(std::max(n, 2 * capacity_));
+    }
+    if (n > size_) {
+        std::fill(data() + size_, data() + n, value);
+    }
+    size_ = n;
+}
+
+void storage::reserve(size_t n) {
+    if (n <= capacity_) {
+        return;
+    }
+    uint32_t* buffer = allocate(n);
+    std::copy(begin(), end(), buffer);
+    size_t old_size = size_;
+    release();
+    heap_ = buffer;
+    capacity_ = n;
+    size_ = old_size;
+}
+
+void storage::clear() {
+    size_ = 0;
+}
+
+void storage::swap(storage& other) noexcept {
+    storage tmp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(tmp);
+}
+
+uint32_t* storage::begin() {
+    return data();
+}
+
+uint32_t* storage::end() {
+    return data() + size_;
+}
+
+uint32_t const* storage::begin() const {
+    return data();
+}
+
+uint32_t const* storage::end() const {
+    return data() + size_;
+}
+
+uint32_t* storage::insert(uint32_t const* pos, size_t count, uint32_t value) {
+    size_t index = pos - begin();
+    size_t old_size = size_;
+    resize(size_ + count);
+    uint32_t* first = data() + index;
+    std::copy_backward(first, data() + old_size, data() + size_);
+    std::fill(first, first + count, value);
+    return first;
+}
+
+bool operator==(storage const& a, storage const& b) {
+    return a.size_ == b.size_ && std::equal(a.begin(), a.end(), b.begin());
+}
+
+bool operator!=(storage const& a, storage const& b) {
+    return !(a == b);
+}
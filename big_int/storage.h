@@ -0,0 +1,63 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Word buffer of big_integer: values of up to INLINE_CAPACITY words are kept
+// inside the object, longer ones spill to the heap.
+struct storage {
+    static size_t const INLINE_CAPACITY = 4;
+
+    storage();                                          // O(1) nothrow
+    storage(size_t n, uint32_t value);                  // O(N) strong
+    storage(uint32_t const* first, uint32_t const* last); // O(N) strong
+    storage(storage const& other);                      // O(N) strong
+    storage(storage&& other) noexcept;                  // O(1) nothrow
+    storage& operator=(storage const& other);           // O(N) strong
+    storage& operator=(storage&& other) noexcept;       // O(1) nothrow
+
+    ~storage();                                         // O(1) nothrow
+
+    uint32_t& operator[](size_t i);                     // O(1) nothrow
+    uint32_t const& operator[](size_t i) const;         // O(1) nothrow
+
+    uint32_t* data();                                   // O(1) nothrow
+    uint32_t const* data() const;                       // O(1) nothrow
+    size_t size() const;                                // O(1) nothrow
+    size_t capacity() const;                            // O(1) nothrow
+    bool empty() const;                                 // O(1) nothrow
+
+    uint32_t& back();                                   // O(1) nothrow
+    uint32_t const& back() const;                       // O(1) nothrow
+    void push_back(uint32_t value);                     // O(1)* strong
+    void pop_back();                                    // O(1) nothrow
+
+    void resize(size_t n, uint32_t value = 0);          // O(N) strong
+    void reserve(size_t n);                             // O(N) strong
+    void clear();                                       // O(1) nothrow
+    void swap(storage& other) noexcept;                 // O(1) nothrow
+
+    uint32_t* begin();                                  // O(1) nothrow
+    uint32_t* end();                                    // O(1) nothrow
+    uint32_t const* begin() const;                      // O(1) nothrow
+    uint32_t const* end() const;                        // O(1) nothrow
+
+    uint32_t* insert(uint32_t const* pos, size_t count, uint32_t value); // O(N) strong
+
+    friend bool operator==(storage const& a, storage const& b);
+    friend bool operator!=(storage const& a, storage const& b);
+
+private:
+    bool is_small() const;
+    void release();
+
+    size_t size_;
+    size_t capacity_;
+    union {
+        uint32_t small_[INLINE_CAPACITY];
+        uint32_t* heap_;
+    };
+};
+
+#endif // STORAGE_H
@@ -0,0 +1,2 @@
+#!/bin/bash
+nasm -f elf64 -o long_arith.o long_arith.asm && ar rcs liblong_arith.a long_arith.o
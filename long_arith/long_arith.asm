@@ -0,0 +1,228 @@
+; Long arithmetic kernels for the System V AMD64 ABI, built into liblong_arith.a.
+; Long numbers are arrays of qwords, least significant first; lengths are in qwords.
+; Results may be written over the first operand unless noted otherwise.
+
+                section         .text
+
+                global          add_long_long
+                global          sub_long_long
+                global          mul_long_short
+                global          add_mul_long_short
+                global          sub_mul_long_short
+                global          div_long_short
+                global          mul_long_long
+
+; adds two long numbers
+;    rdi -- address of result
+;    rsi -- address of summand #1
+;    rdx -- address of summand #2
+;    rcx -- length of long numbers in qwords
+; result:
+;    sum is written to rdi
+;    rax -- carry out
+add_long_long:
+                xor             eax, eax
+                test            rcx, rcx
+                jz              .done
+                lea             rsi, [rsi + 8 * rcx]
+                lea             rdx, [rdx + 8 * rcx]
+                lea             rdi, [rdi + 8 * rcx]
+                neg             rcx
+                clc
+.loop:
+                mov             r8, [rsi + 8 * rcx]
+                adc             r8, [rdx + 8 * rcx]
+                mov             [rdi + 8 * rcx], r8
+                inc             rcx
+                jnz             .loop
+
+                setc            al
+.done:
+                ret
+
+; subtracts two long numbers
+;    rdi -- address of result
+;    rsi -- address of minuend
+;    rdx -- address of subtrahend
+;    rcx -- length of long numbers in qwords
+; result:
+;    difference is written to rdi
+;    rax -- borrow out
+sub_long_long:
+                xor             eax, eax
+                test            rcx, rcx
+                jz              .done
+                lea             rsi, [rsi + 8 * rcx]
+                lea             rdx, [rdx + 8 * rcx]
+                lea             rdi, [rdi + 8 * rcx]
+                neg             rcx
+                clc
+.loop:
+                mov             r8, [rsi + 8 * rcx]
+                sbb             r8, [rdx + 8 * rcx]
+                mov             [rdi + 8 * rcx], r8
+                inc             rcx
+                jnz             .loop
+
+                setc            al
+.done:
+                ret
+
+; multiplies long number by a short
+;    rdi -- address of result
+;    rsi -- address of multiplier #1 (long number)
+;    rdx -- length of long number in qwords
+;    rcx -- multiplier #2 (64-bit unsigned)
+; result:
+;    product is written to rdi
+;    rax -- high qword of the product
+mul_long_short:
+                mov             r8, rdx
+                xor             r9, r9
+                test            r8, r8
+                jz              .done
+                lea             rsi, [rsi + 8 * r8]
+                lea             rdi, [rdi + 8 * r8]
+                neg             r8
+.loop:
+                mov             rax, [rsi + 8 * r8]
+                mul             rcx
+                add             rax, r9
+                adc             rdx, 0
+                mov             [rdi + 8 * r8], rax
+                mov             r9, rdx
+                inc             r8
+                jnz             .loop
+.done:
+                mov             rax, r9
+                ret
+
+; adds product of long number and a short to the result
+;    rdi -- address of result (long number), must not overlap rsi
+;    rsi -- address of multiplier #1 (long number)
+;    rdx -- length of long numbers in qwords
+;    rcx -- multiplier #2 (64-bit unsigned)
+; result:
+;    rdi += rsi * rcx
+;    rax -- carry out qword
+add_mul_long_short:
+                mov             r8, rdx
+                xor             r9, r9
+                test            r8, r8
+                jz              .done
+                lea             rsi, [rsi + 8 * r8]
+                lea             rdi, [rdi + 8 * r8]
+                neg             r8
+.loop:
+                mov             rax, [rsi + 8 * r8]
+                mul             rcx
+                add             rax, r9
+                adc             rdx, 0
+                add             [rdi + 8 * r8], rax
+                adc             rdx, 0
+                mov             r9, rdx
+                inc             r8
+                jnz             .loop
+.done:
+                mov             rax, r9
+                ret
+
+; subtracts product of long number and a short from the result
+;    rdi -- address of result (long number), must not overlap rsi
+;    rsi -- address of multiplier #1 (long number)
+;    rdx -- length of long numbers in qwords
+;    rcx -- multiplier #2 (64-bit unsigned)
+; result:
+;    rdi -= rsi * rcx
+;    rax -- borrow out qword
+sub_mul_long_short:
+                mov             r8, rdx
+                xor             r9, r9
+                test            r8, r8
+                jz              .done
+                lea             rsi, [rsi + 8 * r8]
+                lea             rdi, [rdi + 8 * r8]
+                neg             r8
+.loop:
+                mov             rax, [rsi + 8 * r8]
+                mul             rcx
+                add             rax, r9
+                adc             rdx, 0
+                sub             [rdi + 8 * r8], rax
+                adc             rdx, 0
+                mov             r9, rdx
+                inc             r8
+                jnz             .loop
+.done:
+                mov             rax, r9
+                ret
+
+; divides long number by a short
+;    rdi -- address of quotient
+;    rsi -- address of dividend (long number)
+;    rdx -- length of long number in qwords
+;    rcx -- divisor (64-bit unsigned)
+;    r8  -- remainder carried in from higher qwords, less than rcx
+; result:
+;    quotient is written to rdi
+;    rax -- remainder
+div_long_short:
+                mov             r9, rdx
+                mov             rdx, r8
+                test            r9, r9
+                jz              .done
+.loop:
+                mov             rax, [rsi + 8 * r9 - 8]
+                div             rcx
+                mov             [rdi + 8 * r9 - 8], rax
+                dec             r9
+                jnz             .loop
+.done:
+                mov             rax, rdx
+                ret
+
+; multiplies two long numbers
+;    rdi -- address of result, an + bn qwords, must not overlap the multipliers
+;    rsi -- address of multiplier #1
+;    rdx -- length an of multiplier #1 in qwords, at least 1
+;    rcx -- address of multiplier #2
+;    r8  -- length bn of multiplier #2 in qwords, at least 1
+; result:
+;    product is written to rdi
+mul_long_long:
+                push            rbx
+                push            r12
+                push            r13
+                push            r14
+                push            r15
+
+                mov             r12, rdi
+                mov             r13, rsi
+                mov             r14, rdx
+                mov             r15, rcx
+                mov             rbx, r8
+
+                mov             rcx, [r15]
+                call            mul_long_short
+                mov             [r12 + 8 * r14], rax
+.loop:
+                dec             rbx
+                jz              .done
+                lea             r12, [r12 + 8]
+                lea             r15, [r15 + 8]
+                mov             rdi, r12
+                mov             rsi, r13
+                mov             rdx, r14
+                mov             rcx, [r15]
+                call            add_mul_long_short
+                mov             [r12 + 8 * r14], rax
+                jmp             .loop
+.done:
+                pop             r15
+                pop             r14
+                pop             r13
+                pop             r12
+                pop             rbx
+                ret
+
+                section         .note.GNU-stack noalloc noexec nowrite progbits
@@ -0,0 +1,32 @@
+#ifndef LONG_ARITH_H
+#define LONG_ARITH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Kernels of long_arith.asm. Long numbers are arrays of qwords, least significant first,
+// lengths are in qwords; r may equal the first operand unless noted otherwise.
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// r = a + b, returns carry out
+uint64_t add_long_long(uint64_t* r, uint64_t const* a, uint64_t const* b, size_t n);
+// r = a - b, returns borrow out
+uint64_t sub_long_long(uint64_t* r, uint64_t const* a, uint64_t const* b, size_t n);
+// r = a * b, returns high qword
+uint64_t mul_long_short(uint64_t* r, uint64_t const* a, size_t n, uint64_t b);
+// r += a * b, returns carry out qword; r must not overlap a
+uint64_t add_mul_long_short(uint64_t* r, uint64_t const* a, size_t n, uint64_t b);
+// r -= a * b, returns borrow out qword; r must not overlap a
+uint64_t sub_mul_long_short(uint64_t* r, uint64_t const* a, size_t n, uint64_t b);
+// q = (rem * 2^(64n) + a) / d, returns the remainder; rem < d
+uint64_t div_long_short(uint64_t* q, uint64_t const* a, size_t n, uint64_t d, uint64_t rem);
+// r[0..an + bn) = a * b; an, bn >= 1, r must not overlap a or b
+void mul_long_long(uint64_t* r, uint64_t const* a, size_t an, uint64_t const* b, size_t bn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LONG_ARITH_H
@@ -1,2 +1,3 @@
 #!/bin/bash
-nasm -f elf64 -o $1.o $1.asm && ld -o $1 $1.o
+(cd ../long_arith && ./compile.sh) || exit 1
+nasm -f elf64 -o $1.o $1.asm && ld -o $1 $1.o ../long_arith/liblong_arith.a
@@ -1,22 +1,38 @@
                 section         .text
 
+; The kernels shared with liblong_arith (see ../long_arith/long_arith.h) are called from there.
+                extern          add_long_long, sub_long_long, div_long_short, mul_long_long
+
+; operands shorter than this (in qwords) are multiplied by the schoolbook method
+KARATSUBA_THRESHOLD: equ        32
+
                 global          _start
 _start:
 
-                sub             rsp, 3 * 128 * 8
-                mov             rcx, 128
-                lea             rdi, [rsp + 2 * 128 * 8]
                 call            read_long
-                lea             rdi, [rsp + 1 * 128 * 8]
+                mov             r12, rdi
+                mov             r13, rcx
                 call            read_long
-                lea             rsi, [rsp + 2 * 128 * 8]
-                lea	r8, [rsp + 1 * 128 * 8]
-                mov 	rdi, rsp
-                
-                call	set_zero
-                call            mul_long_long
-	
-	mov	rcx, 256
+                mov             r8, rdi
+                mov             r9, rcx
+                mov             rsi, r12
+                mov             rcx, r13
+
+                lea             r14, [rcx + r9]
+                push            rcx
+                mov             rcx, r14
+                call            alloc
+                mov             rdi, rax
+                lea             rcx, [r14 + 4 * r14]
+                add             rcx, rcx
+                add             rcx, 1024
+                call            alloc
+                mov             r10, rax
+                pop             rcx
+
+                call            multiply
+
+                mov             rcx, r14
                 call            write_long
 
                 mov             al, 0x0a
@@ -24,60 +40,318 @@ _start:
 
                 jmp             exit
 
-;rsi, r8, rdi
-;rcx -- length
-mul_long_long:
-	push	rsi
-	push	r8
-	push	rdi
-	push	rcx
-.loop1:
-	mov	rbx, [r8]
-	mov	qword[r8], 0 
-	call	add_mul_long_short
-	
-	lea	rdi, [rdi + 8]
-	
-	lea	r8, [r8 + 8]
-	cmp	r8, rsi
-	jne	.loop1
-	
-	pop	rcx
-	pop	rdi
-	pop	r8
-	pop	rsi
-	ret
-
-add_mul_long_short:
-	push	rdi
-	push	rcx
-	push	rsi
-	xor	r9, r9
-	xor	rdx, rdx
-	clc
-.loop2:
-	add	[rdi], r9
-	xor	r9, r9
-	adc	r9, 0
-	add 	[rdi], rdx
-	adc	r9, 0
-	
-	mov	rax, [rsi]
-	mul 	rbx
-	add 	[rdi], rax
-	adc 	r9, 0
-	
-	lea	rdi, [rdi + 8]
-	lea	rsi, [rsi + 8]
-	dec	rcx
-	jnz	.loop2
-	
-	add 	[rdi], r9
-	add 	[rdi], rdx
-	pop	rsi
-	pop	rcx
-	pop	rdi
-	ret
+; multiplies two long numbers
+;    rdi -- address of result (rcx + r9 qwords), must not overlap the multipliers
+;    rsi -- address of multiplier #1
+;    rcx -- length of multiplier #1 in qwords
+;    r8  -- address of multiplier #2
+;    r9  -- length of multiplier #2 in qwords
+;    r10 -- scratch space, 10 * (rcx + r9) + 1024 qwords
+; result:
+;    product is written to rdi
+multiply:
+                push            rax
+                push            rbx
+                push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+                push            r8
+                push            r9
+                push            r11
+                push            r12
+
+                cmp             rcx, r9
+                jae             .ordered
+                xchg            rsi, r8
+                xchg            rcx, r9
+.ordered:
+                cmp             r9, KARATSUBA_THRESHOLD
+                jae             .big
+                call            mul_basecase
+                jmp             .done
+.big:
+                cmp             rcx, r9
+                jne             .unbalanced
+                call            mul_karatsuba
+                jmp             .done
+
+; the longer multiplier is cut into pieces of the length of the shorter one
+.unbalanced:
+                push            rcx
+                add             rcx, r9
+                call            set_zero
+                pop             rcx
+
+                mov             r11, rcx
+                mov             r12, rdi
+.piece:
+                mov             rbx, r11
+                cmp             rbx, r9
+                jbe             .last
+                mov             rbx, r9
+.last:
+                push            rcx
+                push            rdi
+                push            r10
+                mov             rdi, r10
+                lea             r10, [r10 + 8 * r9]
+                lea             r10, [r10 + 8 * r9]
+                mov             rcx, rbx
+                call            multiply
+                pop             r10
+                pop             rdi
+
+                mov             rdx, rdi
+                mov             rdi, r12
+                push            rsi
+                mov             rsi, r10
+                lea             rcx, [rbx + r9]
+                call            add_in_place
+                pop             rsi
+                lea             rdi, [rdi + 8 * rcx]
+                mov             rcx, r11
+                sub             rcx, rbx
+                jz              .added
+                call            add_long_short
+.added:
+                mov             rdi, rdx
+                pop             rcx
+
+                lea             rsi, [rsi + 8 * rbx]
+                lea             r12, [r12 + 8 * rbx]
+                sub             r11, rbx
+                jnz             .piece
+.done:
+                pop             r12
+                pop             r11
+                pop             r9
+                pop             r8
+                pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                pop             rbx
+                pop             rax
+                ret
+
+; multiplies two long numbers of the same length by Karatsuba's method
+;    rdi -- address of result (2 * rcx qwords), must not overlap the multipliers
+;    rsi -- address of multiplier #1
+;    r8  -- address of multiplier #2
+;    rcx -- length of multipliers in qwords
+;    r10 -- scratch space, 4 * rcx + 1024 qwords
+; result:
+;    product is written to rdi
+mul_karatsuba:
+                cmp             rcx, KARATSUBA_THRESHOLD
+                jae             .split
+                push            r9
+                mov             r9, rcx
+                call            mul_basecase
+                pop             r9
+                ret
+.split:
+                push            rax
+                push            rcx
+                push            rsi
+                push            rdi
+                push            r8
+                push            r10
+                push            r11
+                push            r12
+                push            r13
+                push            r14
+                push            r15
+
+                ; n = h + k, a = a1 * 2^(64h) + a0, b = b1 * 2^(64h) + b0
+                mov             r12, rcx
+                mov             r13, rcx
+                shr             r13, 1
+                mov             r14, r12
+                sub             r14, r13
+                lea             r15, [r14 + 1]
+
+                ; a0 * b0 and a1 * b1 go straight to the low and high halves of the result
+                mov             rcx, r13
+                call            mul_karatsuba
+                push            rsi
+                push            rdi
+                push            r8
+                lea             rsi, [rsi + 8 * r13]
+                lea             rdi, [rdi + 8 * r13]
+                lea             rdi, [rdi + 8 * r13]
+                lea             r8, [r8 + 8 * r13]
+                mov             rcx, r14
+                call            mul_karatsuba
+                pop             r8
+                pop             rdi
+                pop             rsi
+
+                ; (a0 + a1) and (b0 + b1), k + 1 qwords each, at the start of the scratch space
+                mov             r11, rdi
+                mov             rdi, r10
+                call            sum_halves
+                lea             rdi, [r10 + 8 * r15]
+                push            rsi
+                mov             rsi, r8
+                call            sum_halves
+                pop             rsi
+
+                ; (a0 + a1) * (b0 + b1) - a0 * b0 - a1 * b1, 2k + 2 qwords after them
+                mov             rsi, r10
+                lea             r8, [r10 + 8 * r15]
+                lea             rdi, [r8 + 8 * r15]
+                mov             rcx, r15
+                push            r10
+                lea             r10, [rdi + 8 * r15]
+                lea             r10, [r10 + 8 * r15]
+                call            mul_karatsuba
+                pop             r10
+
+                mov             rsi, r11
+                lea             rcx, [r13 + r13]
+                call            sub_in_place
+                push            rdi
+                lea             rdi, [rdi + 8 * rcx]
+                lea             rcx, [r15 + r15]
+                sub             rcx, r13
+                sub             rcx, r13
+                call            sub_long_short
+                pop             rdi
+
+                lea             rsi, [r11 + 8 * r13]
+                lea             rsi, [rsi + 8 * r13]
+                lea             rcx, [r14 + r14]
+                call            sub_in_place
+                push            rdi
+                lea             rdi, [rdi + 8 * rcx]
+                mov             rcx, 2
+                call            sub_long_short
+                pop             rdi
+
+                ; added to the result from qword h on
+                mov             rsi, rdi
+                lea             rdi, [r11 + 8 * r13]
+                lea             rcx, [r15 + r15]
+                call            add_in_place
+                lea             rdi, [rdi + 8 * rcx]
+                lea             rcx, [r12 + r12]
+                sub             rcx, r13
+                sub             rcx, r15
+                sub             rcx, r15
+                jz              .done
+                call            add_long_short
+.done:
+                pop             r15
+                pop             r14
+                pop             r13
+                pop             r12
+                pop             r11
+                pop             r10
+                pop             r8
+                pop             rdi
+                pop             rsi
+                pop             rcx
+                pop             rax
+                ret
+
+; sums the halves of a long number split as in mul_karatsuba
+;    rdi -- address of result (r15 qwords)
+;    rsi -- address of long number (r12 qwords)
+;    r13 -- length of the low half, r14 -- of the high half, r15 = r14 + 1
+sum_halves:
+                push            rax
+                push            rcx
+                push            rsi
+                push            rdi
+
+                push            rsi
+                lea             rsi, [rsi + 8 * r13]
+                mov             rcx, r14
+                rep movsq
+                mov             qword [rdi], 0
+                pop             rsi
+
+                mov             rdi, [rsp]
+                mov             rcx, r13
+                call            add_in_place
+                lea             rdi, [rdi + 8 * rcx]
+                mov             rcx, r15
+                sub             rcx, r13
+                call            add_long_short
+
+                pop             rdi
+                pop             rsi
+                pop             rcx
+                pop             rax
+                ret
+
+; multiplies two long numbers by the schoolbook method, by mul_long_long of liblong_arith
+;    rdi -- address of result (rcx + r9 qwords), must not overlap the multipliers
+;    rsi -- address of multiplier #1
+;    rcx -- length of multiplier #1 in qwords
+;    r8  -- address of multiplier #2
+;    r9  -- length of multiplier #2 in qwords
+; result:
+;    product is written to rdi
+mul_basecase:
+                push            rax
+                push            rcx
+                push            rdx
+                push            r8
+
+                mov             rdx, rcx
+                mov             rcx, r8
+                mov             r8, r9
+                mov             rax, mul_long_long
+                call            abi_call
+
+                pop             r8
+                pop             rdx
+                pop             rcx
+                pop             rax
+                ret
+
+; adds two long numbers in place, by add_long_long of liblong_arith
+;    rdi -- address of summand #1 (long number)
+;    rsi -- address of summand #2 (long number)
+;    rcx -- length of long numbers in qwords
+; result:
+;    sum is written to rdi
+;    rax -- carry out
+add_in_place:
+                push            rdx
+                push            rsi
+
+                mov             rdx, rsi
+                mov             rsi, rdi
+                mov             rax, add_long_long
+                call            abi_call
+
+                pop             rsi
+                pop             rdx
+                ret
+
+; subtracts two long numbers in place, by sub_long_long of liblong_arith
+;    rdi -- address of minuend (long number)
+;    rsi -- address of subtrahend (long number)
+;    rcx -- length of long numbers in qwords
+; result:
+;    difference is written to rdi
+;    rax -- borrow out
+sub_in_place:
+                push            rdx
+                push            rsi
+
+                mov             rdx, rsi
+                mov             rsi, rdi
+                mov             rax, sub_long_long
+                call            abi_call
+
+                pop             rsi
+                pop             rdx
+                ret
 
 ; adds 64-bit number to long number
 ;    rdi -- address of summand #1 (long number)
@@ -86,6 +360,7 @@ add_mul_long_short:
 ; result:
 ;    sum is written to rdi
 add_long_short:
+                push            rax
                 push            rdi
                 push            rcx
                 push            rdx
@@ -103,20 +378,54 @@ add_long_short:
                 pop             rdx
                 pop             rcx
                 pop             rdi
+                pop             rax
                 ret
 
-; multiplies long number by a short
-;    rdi -- address of multiplier #1 (long number)
-;    rbx -- multiplier #2 (64-bit unsigned)
+; subtracts 64-bit number from long number
+;    rdi -- address of minuend (long number)
+;    rax -- subtrahend (64-bit unsigned)
 ;    rcx -- length of long number in qwords
 ; result:
-;    product is written to rdi
-mul_long_short:
+;    difference is written to rdi
+sub_long_short:
                 push            rax
                 push            rdi
                 push            rcx
+                push            rdx
 
-                xor             rsi, rsi
+                xor             rdx,rdx
+.loop:
+                sub             [rdi], rax
+                adc             rdx, 0
+                mov             rax, rdx
+                xor             rdx, rdx
+                add             rdi, 8
+                dec             rcx
+                jnz             .loop
+
+                pop             rdx
+                pop             rcx
+                pop             rdi
+                pop             rax
+                ret
+
+; multiplies long number by a short and adds a short
+;    rdi -- address of long number
+;    rbx -- multiplier (64-bit unsigned)
+;    rax -- summand (64-bit unsigned)
+;    rcx -- length of long number in qwords, may be zero
+; result:
+;    rdi = rdi * rbx + rax
+;    rax -- carry out qword
+mul_add_long_short:
+                push            rdi
+                push            rcx
+                push            rdx
+                push            rsi
+
+                mov             rsi, rax
+                test            rcx, rcx
+                jz              .done
 .loop:
                 mov             rax, [rdi]
                 mul             rbx
@@ -127,38 +436,71 @@ mul_long_short:
                 mov             rsi, rdx
                 dec             rcx
                 jnz             .loop
-
+.done:
+                mov             rax, rsi
+                pop             rsi
+                pop             rdx
                 pop             rcx
                 pop             rdi
-                pop             rax
                 ret
 
-; divides long number by a short
+; divides long number by a short in place, by div_long_short of liblong_arith
 ;    rdi -- address of dividend (long number)
 ;    rbx -- divisor (64-bit unsigned)
 ;    rcx -- length of long number in qwords
 ; result:
 ;    quotient is written to rdi
 ;    rdx -- remainder
-div_long_short:
-                push            rdi
+div_in_place:
                 push            rax
                 push            rcx
+                push            rsi
+                push            r8
+
+                mov             rsi, rdi
+                mov             rdx, rcx
+                mov             rcx, rbx
+                xor             r8, r8
+                mov             rax, div_long_short
+                call            abi_call
+                mov             rdx, rax
+
+                pop             r8
+                pop             rsi
+                pop             rcx
+                pop             rax
+                ret
 
-                lea             rdi, [rdi + 8 * rcx - 8]
-                xor             rdx, rdx
+; calls a liblong_arith routine, the System V ABI way
+;    rax -- address of the routine
+;    rdi, rsi, rdx, rcx, r8 -- its arguments
+; result:
+;    rax -- its return value; all other registers are kept
+abi_call:
+                push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+                push            rbp
+                mov             rbp, rsp
+                and             rsp, -16
 
-.loop:
-                mov             rax, [rdi]
-                div             rbx
-                mov             [rdi], rax
-                sub             rdi, 8
-                dec             rcx
-                jnz             .loop
+                call            rax
 
-                pop             rcx
-                pop             rax
+                mov             rsp, rbp
+                pop             rbp
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
                 pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
                 ret
 
 ; assigns a zero to long number
@@ -177,36 +519,69 @@ set_zero:
                 pop             rax
                 ret
 
-; checks if a long number is a zero
-;    rdi -- argument (long number)
-;    rcx -- length of long number in qwords
+; takes memory from the end of the data segment
+;    rcx -- size in qwords
 ; result:
-;    ZF=1 if zero
-is_zero:
-                push            rax
-                push            rdi
+;    rax -- address of the block
+alloc:
                 push            rcx
+                push            rsi
+                push            rdi
+                push            r11
 
-                xor             rax, rax
-                rep scasq
+                mov             rax, [heap_end]
+                test            rax, rax
+                jnz             .grow
+                mov             rax, 12
+                xor             rdi, rdi
+                syscall
+                mov             [heap_end], rax
+.grow:
+                mov             rsi, rax
+                mov             rcx, [rsp + 24]
+                lea             rdi, [rax + 8 * rcx]
+                mov             rax, 12
+                syscall
+                cmp             rax, rdi
+                jne             .out_of_memory
+                mov             [heap_end], rax
+                mov             rax, rsi
 
-                pop             rcx
+                pop             r11
                 pop             rdi
-                pop             rax
+                pop             rsi
+                pop             rcx
                 ret
 
+.out_of_memory:
+                mov             rsi, out_of_memory_msg
+                mov             rdx, out_of_memory_msg_size
+                call            print_string
+                jmp             exit
+
 ; read long number from stdin
-;    rdi -- location for output (long number)
-;    rcx -- length of long number in qwords
+; result:
+;    rdi -- address of long number
+;    rcx -- length of long number in qwords, without leading zero qwords (at least 1)
 read_long:
-                push            rcx
-                push            rdi
-
-                call            set_zero
+                push            rax
+                push            rbx
+                push            rdx
+                push            rsi
+                push            r8
+                push            r9
+                push            r10
+
+                ; digits are collected on the heap first, a page at a time
+                mov             rcx, 512
+                call            alloc
+                mov             r8, rax
+                mov             r9, rax
+                lea             r10, [rax + 8 * 512]
 .loop:
                 call            read_char
                 or              rax, rax
-                js              exit
+                js              .done
                 cmp             rax, 0x0a
                 je              .done
                 cmp             rax, '0'
@@ -214,15 +589,76 @@ read_long:
                 cmp             rax, '9'
                 ja              .invalid_char
 
-                sub             rax, '0'
-                mov             rbx, 10
-                call            mul_long_short
-                call            add_long_short
+                cmp             r9, r10
+                jne             .store
+                push            rax
+                mov             rcx, 512
+                call            alloc
+                pop             rax
+                lea             r10, [r10 + 8 * 512]
+.store:
+                mov             [r9], al
+                inc             r9
                 jmp             .loop
 
 .done:
-                pop             rdi
+                ; a qword holds 19 decimal digits, which are added 19 at a time;
+                ; r10 counts the qwords in use so far
+                mov             rax, r9
+                sub             rax, r8
+                xor             rdx, rdx
+                mov             rcx, 19
+                div             rcx
+                mov             rsi, rdx
+                lea             rcx, [rax + 1]
+                call            alloc
+                mov             rdi, rax
+                call            set_zero
+
+                test            rsi, rsi
+                jnz             .first
+                mov             rsi, 19
+.first:
+                xor             r10, r10
+                mov             rbx, 10000000000000000000
+.chunk:
+                cmp             r8, r9
+                je              .converted
+                xor             rax, rax
+.digit:
+                imul            rax, rax, 10
+                movzx           rdx, byte [r8]
+                sub             rdx, '0'
+                add             rax, rdx
+                inc             r8
+                dec             rsi
+                jnz             .digit
+
+                push            rcx
+                mov             rcx, r10
+                call            mul_add_long_short
                 pop             rcx
+                test            rax, rax
+                jz              .next
+                mov             [rdi + 8 * r10], rax
+                inc             r10
+.next:
+                mov             rsi, 19
+                jmp             .chunk
+
+.converted:
+                mov             rcx, r10
+                test            rcx, rcx
+                jnz             .trimmed
+                inc             rcx
+.trimmed:
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rsi
+                pop             rdx
+                pop             rbx
+                pop             rax
                 ret
 
 .invalid_char:
@@ -242,65 +678,142 @@ read_long:
                 jmp             .skip_loop
 
 ; write long number to stdout
-;    rdi -- argument (long number)
+;    rdi -- argument (long number), destroyed
 ;    rcx -- length of long number in qwords
 write_long:
                 push            rax
+                push            rbx
                 push            rcx
+                push            rdx
+                push            rsi
+                push            rbp
+                push            r8
 
+                ; at most 20 digits per qword
                 mov             rax, 20
                 mul             rcx
-                mov             rbp, rsp
-                sub             rsp, rax
+                mov             rbp, rax
+                push            rcx
+                lea             rcx, [rax + 7]
+                shr             rcx, 3
+                call            alloc
+                pop             rcx
+                add             rbp, rax
 
                 mov             rsi, rbp
+.trim:
+                cmp             rcx, 1
+                je              .loop
+                cmp             qword [rdi + 8 * rcx - 8], 0
+                jne             .loop
+                dec             rcx
+                jmp             .trim
 
+                ; 19 digits per division; zero high qwords are dropped as they appear
 .loop:
-                mov             rbx, 10
-                call            div_long_short
-                add             rdx, '0'
-                dec             rsi
-                mov             [rsi], dl
-                call            is_zero
-                jnz             .loop
+                mov             rbx, 10000000000000000000
+                call            div_in_place
+                mov             rax, rdx
+.shrink:
+                cmp             qword [rdi + 8 * rcx - 8], 0
+                jne             .middle
+                dec             rcx
+                jnz             .shrink
+
+                mov             r8, 1
+                call            put_digits
+                jmp             .print
+.middle:
+                mov             r8, 19
+                call            put_digits
+                jmp             .loop
 
+.print:
                 mov             rdx, rbp
                 sub             rdx, rsi
                 call            print_string
 
-                mov             rsp, rbp
+                pop             r8
+                pop             rbp
+                pop             rsi
+                pop             rdx
                 pop             rcx
+                pop             rbx
                 pop             rax
                 ret
 
-; read one char from stdin
+; puts decimal digits of a qword before the given position
+;    rax -- value
+;    rsi -- position after the last digit
+;    r8  -- least number of digits, the rest is padded with zeroes
+; result:
+;    rsi -- position of the first digit
+put_digits:
+                push            rax
+                push            rbx
+                push            rdx
+                push            r8
+
+                mov             rbx, 10
+.loop:
+                xor             rdx, rdx
+                div             rbx
+                add             rdx, '0'
+                dec             rsi
+                mov             [rsi], dl
+                dec             r8
+                jg              .loop
+                test            rax, rax
+                jnz             .loop
+
+                pop             r8
+                pop             rdx
+                pop             rbx
+                pop             rax
+                ret
+
+; read one char from stdin, a buffer at a time
 ; result:
 ;    rax == -1 if error occurs
 ;    rax \in [0; 255] if OK
 read_char:
                 push            rcx
+                push            rdx
+                push            rsi
                 push            rdi
+                push            r11
 
-                sub             rsp, 1
+                mov             rcx, [input_pos]
+                cmp             rcx, [input_end]
+                jne             .buffered
                 xor             rax, rax
                 xor             rdi, rdi
-                mov             rsi, rsp
-                mov             rdx, 1
+                mov             rsi, input_buffer
+                mov             rdx, input_buffer_size
                 syscall
 
-                cmp             rax, 1
-                jne             .error
+                cmp             rax, 0
+                jle             .error
+                mov             [input_end], rax
+                xor             rcx, rcx
+.buffered:
                 xor             rax, rax
-                mov             al, [rsp]
-                add             rsp, 1
+                mov             al, [input_buffer + rcx]
+                inc             rcx
+                mov             [input_pos], rcx
 
+                pop             r11
                 pop             rdi
+                pop             rsi
+                pop             rdx
                 pop             rcx
                 ret
 .error:
                 mov             rax, -1
-                add             rsp, 1
+                pop             r11
                 pop             rdi
+                pop             rsi
+                pop             rdx
                 pop             rcx
                 ret
 
@@ -328,11 +841,17 @@ exit:
 ;    rdx -- size
 print_string:
                 push            rax
+                push            rcx
+                push            rdi
+                push            r11
 
                 mov             rax, 1
                 mov             rdi, 1
                 syscall
 
+                pop             r11
+                pop             rdi
+                pop             rcx
                 pop             rax
                 ret
 
@@ -341,3 +860,13 @@ print_string:
 invalid_char_msg:
                 db              "Invalid character: "
 invalid_char_msg_size: equ             $ - invalid_char_msg
+out_of_memory_msg:
+                db              "Out of memory", 0x0a
+out_of_memory_msg_size: equ             $ - out_of_memory_msg
+
+                section         .bss
+heap_end:       resq            1
+input_pos:      resq            1
+input_end:      resq            1
+input_buffer_size: equ          4096
+input_buffer:   resb            input_buffer_size
@@ -1 +1,6 @@
+import sys
+
+if hasattr(sys, "set_int_max_str_digits"):
+    sys.set_int_max_str_digits(0)
+
 print(int(input()) * int(input()))
@@ -1,9 +1,16 @@
 import random
+import sys
 
-min_value = 0
-max_value = 2 ** (64 * 128) - 1
+if hasattr(sys, "set_int_max_str_digits"):
+    sys.set_int_max_str_digits(0)
 
-a = random.randint(min_value, max_value)
-b = random.randint(min_value, max_value)
-print(a)
-print(b)
+min_length = 1
+max_length = 512
+
+
+def random_long():
+    return random.randint(0, 2 ** (64 * random.randint(min_length, max_length)) - 1)
+
+
+print(random_long())
+print(random_long())
@@ -1,4 +1,5 @@
 #!/bin/bash
+./compile.sh mul || exit 1
 for (( t = 1; t < 1000; t++ ))
 do
     python3 random_mul_input.py > inp.txt || break
@@ -1,5 +1,8 @@
                 section         .text
 
+; The kernels shared with liblong_arith (see ../long_arith/long_arith.h) are called from there.
+                extern          sub_long_long, div_long_short
+
                 global          _start
 _start:
 
@@ -10,7 +13,7 @@ _start:
                 mov             rdi, rsp
                 call            read_long
                 lea             rsi, [rsp + 128 * 8]
-                call            sub_long_long
+                call            sub_in_place
 
                 call            write_long
 
@@ -19,53 +22,24 @@ _start:
 
                 jmp             exit
 
-; adds two long number
-;    rdi -- address of summand #1 (long number)
-;    rsi -- address of summand #2 (long number)
+; subtracts two long numbers in place, by sub_long_long of liblong_arith
+;    rdi -- address of minuend (long number)
+;    rsi -- address of subtrahend (long number)
 ;    rcx -- length of long numbers in qwords
 ; result:
-;    sum is written to rdi
-add_long_long:
-                push            rdi
-                push            rsi
-                push            rcx
-
-                clc
-.loop:
-                mov             rax, [rsi]
-                lea             rsi, [rsi + 8]
-                adc             [rdi], rax
-                lea             rdi, [rdi + 8]
-                dec             rcx
-                jnz             .loop
-
-                pop             rcx
-                pop             rsi
-                pop             rdi
-                ret
-; adds two long number
-;    rdi -- address of summand #1 (long number)
-;    rsi -- address of summand #2 (long number)
-;    rcx -- length of long numbers in qwords
-; result:
-;    sum is written to rdi
-sub_long_long:
-                push            rdi
+;    difference is written to rdi
+;    rax -- borrow out
+sub_in_place:
+                push            rdx
                 push            rsi
-                push            rcx
 
-                clc
-.loop:
-                mov             rax, [rsi]
-                lea             rsi, [rsi + 8]
-                sbb             [rdi], rax
-                lea             rdi, [rdi + 8]
-                dec             rcx
-                jnz             .loop
+                mov             rdx, rsi
+                mov             rsi, rdi
+                mov             rax, sub_long_long
+                call            abi_call
 
-                pop             rcx
                 pop             rsi
-                pop             rdi
+                pop             rdx
                 ret
 
 ; adds 64-bit number to long number
@@ -94,18 +68,23 @@ add_long_short:
                 pop             rdi
                 ret
 
-; multiplies long number by a short
-;    rdi -- address of multiplier #1 (long number)
-;    rbx -- multiplier #2 (64-bit unsigned)
-;    rcx -- length of long number in qwords
+; multiplies long number by a short and adds a short
+;    rdi -- address of long number
+;    rbx -- multiplier (64-bit unsigned)
+;    rax -- summand (64-bit unsigned)
+;    rcx -- length of long number in qwords, may be zero
 ; result:
-;    product is written to rdi
-mul_long_short:
-                push            rax
+;    rdi = rdi * rbx + rax
+;    rax -- carry out qword
+mul_add_long_short:
                 push            rdi
                 push            rcx
+                push            rdx
+                push            rsi
 
-                xor             rsi, rsi
+                mov             rsi, rax
+                test            rcx, rcx
+                jz              .done
 .loop:
                 mov             rax, [rdi]
                 mul             rbx
@@ -116,68 +95,83 @@ mul_long_short:
                 mov             rsi, rdx
                 dec             rcx
                 jnz             .loop
-
+.done:
+                mov             rax, rsi
+                pop             rsi
+                pop             rdx
                 pop             rcx
                 pop             rdi
-                pop             rax
                 ret
 
-; divides long number by a short
+; divides long number by a short in place, by div_long_short of liblong_arith
 ;    rdi -- address of dividend (long number)
 ;    rbx -- divisor (64-bit unsigned)
 ;    rcx -- length of long number in qwords
 ; result:
 ;    quotient is written to rdi
 ;    rdx -- remainder
-div_long_short:
-                push            rdi
+div_in_place:
                 push            rax
                 push            rcx
+                push            rsi
+                push            r8
 
-                lea             rdi, [rdi + 8 * rcx - 8]
-                xor             rdx, rdx
-
-.loop:
-                mov             rax, [rdi]
-                div             rbx
-                mov             [rdi], rax
-                sub             rdi, 8
-                dec             rcx
-                jnz             .loop
+                mov             rsi, rdi
+                mov             rdx, rcx
+                mov             rcx, rbx
+                xor             r8, r8
+                mov             rax, div_long_short
+                call            abi_call
+                mov             rdx, rax
 
+                pop             r8
+                pop             rsi
                 pop             rcx
                 pop             rax
-                pop             rdi
                 ret
 
-; assigns a zero to long number
-;    rdi -- argument (long number)
-;    rcx -- length of long number in qwords
-set_zero:
-                push            rax
-                push            rdi
+; calls a liblong_arith routine, the System V ABI way
+;    rax -- address of the routine
+;    rdi, rsi, rdx, rcx, r8 -- its arguments
+; result:
+;    rax -- its return value; all other registers are kept
+abi_call:
                 push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+                push            rbp
+                mov             rbp, rsp
+                and             rsp, -16
 
-                xor             rax, rax
-                rep stosq
+                call            rax
 
-                pop             rcx
+                mov             rsp, rbp
+                pop             rbp
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
                 pop             rdi
-                pop             rax
+                pop             rsi
+                pop             rdx
+                pop             rcx
                 ret
 
-; checks if a long number is a zero
+; assigns a zero to long number
 ;    rdi -- argument (long number)
 ;    rcx -- length of long number in qwords
-; result:
-;    ZF=1 if zero
-is_zero:
+set_zero:
                 push            rax
                 push            rdi
                 push            rcx
 
                 xor             rax, rax
-                rep scasq
+                rep stosq
 
                 pop             rcx
                 pop             rdi
@@ -190,8 +184,16 @@ is_zero:
 read_long:
                 push            rcx
                 push            rdi
+                push            r8
+                push            r9
+                push            r10
 
                 call            set_zero
+                ; digits are gathered into a qword 19 at a time;
+                ; r8 counts the qwords in use, r9 is the pending chunk of r10 digits
+                xor             r8, r8
+                xor             r9, r9
+                xor             r10, r10
 .loop:
                 call            read_char
                 or              rax, rax
@@ -204,12 +206,22 @@ read_long:
                 ja              .invalid_char
 
                 sub             rax, '0'
-                mov             rbx, 10
-                call            mul_long_short
-                call            add_long_short
+                imul            r9, r9, 10
+                add             r9, rax
+                inc             r10
+                cmp             r10, 19
+                jne             .loop
+                call            add_chunk
                 jmp             .loop
 
 .done:
+                test            r10, r10
+                jz              .added
+                call            add_chunk
+.added:
+                pop             r10
+                pop             r9
+                pop             r8
                 pop             rdi
                 pop             rcx
                 ret
@@ -230,12 +242,42 @@ read_long:
                 je              exit
                 jmp             .skip_loop
 
+; appends a chunk of decimal digits to a long number
+;    rdi -- address of long number
+;    rcx -- length of long number in qwords
+;    r8  -- number of qwords in use, updated
+;    r9  -- chunk value, reset to zero
+;    r10 -- number of digits in the chunk, reset to zero
+add_chunk:
+                push            rax
+                push            rbx
+                push            rcx
+
+                mov             rbx, [pow10 + 8 * r10]
+                mov             rax, r9
+                mov             rcx, r8
+                call            mul_add_long_short
+                test            rax, rax
+                jz              .done
+                cmp             r8, [rsp]
+                je              .done
+                mov             [rdi + 8 * r8], rax
+                inc             r8
+.done:
+                xor             r9, r9
+                xor             r10, r10
+                pop             rcx
+                pop             rbx
+                pop             rax
+                ret
+
 ; write long number to stdout
-;    rdi -- argument (long number)
+;    rdi -- argument (long number), destroyed
 ;    rcx -- length of long number in qwords
 write_long:
                 push            rax
                 push            rcx
+                push            r8
 
                 mov             rax, 20
                 mul             rcx
@@ -243,26 +285,75 @@ write_long:
                 sub             rsp, rax
 
                 mov             rsi, rbp
+.trim:
+                cmp             rcx, 1
+                je              .loop
+                cmp             qword [rdi + 8 * rcx - 8], 0
+                jne             .loop
+                dec             rcx
+                jmp             .trim
 
+                ; 19 digits per division; zero high qwords are dropped as they appear
 .loop:
-                mov             rbx, 10
-                call            div_long_short
-                add             rdx, '0'
-                dec             rsi
-                mov             [rsi], dl
-                call            is_zero
-                jnz             .loop
+                mov             rbx, [pow10 + 8 * 19]
+                call            div_in_place
+                mov             rax, rdx
+.shrink:
+                cmp             qword [rdi + 8 * rcx - 8], 0
+                jne             .middle
+                dec             rcx
+                jnz             .shrink
+
+                mov             r8, 1
+                call            put_digits
+                jmp             .print
+.middle:
+                mov             r8, 19
+                call            put_digits
+                jmp             .loop
 
+.print:
                 mov             rdx, rbp
                 sub             rdx, rsi
                 call            print_string
 
                 mov             rsp, rbp
+                pop             r8
                 pop             rcx
                 pop             rax
                 ret
 
-; read one char from stdin
+; puts decimal digits of a qword before the given position
+;    rax -- value
+;    rsi -- position after the last digit
+;    r8  -- least number of digits, the rest is padded with zeroes
+; result:
+;    rsi -- position of the first digit
+put_digits:
+                push            rax
+                push            rbx
+                push            rdx
+                push            r8
+
+                mov             rbx, 10
+.loop:
+                xor             rdx, rdx
+                div             rbx
+                add             rdx, '0'
+                dec             rsi
+                mov             [rsi], dl
+                dec             r8
+                jg              .loop
+                test            rax, rax
+                jnz             .loop
+
+                pop             r8
+                pop             rdx
+                pop             rbx
+                pop             rax
+                ret
+
+; read one char from stdin, a buffer at a time
 ; result:
 ;    rax == -1 if error occurs
 ;    rax \in [0; 255] if OK
@@ -270,25 +361,30 @@ read_char:
                 push            rcx
                 push            rdi
 
-                sub             rsp, 1
+                mov             rcx, [input_pos]
+                cmp             rcx, [input_end]
+                jne             .buffered
                 xor             rax, rax
                 xor             rdi, rdi
-                mov             rsi, rsp
-                mov             rdx, 1
+                mov             rsi, input_buffer
+                mov             rdx, input_buffer_size
                 syscall
 
-                cmp             rax, 1
-                jne             .error
+                cmp             rax, 0
+                jle             .error
+                mov             [input_end], rax
+                xor             rcx, rcx
+.buffered:
                 xor             rax, rax
-                mov             al, [rsp]
-                add             rsp, 1
+                mov             al, [input_buffer + rcx]
+                inc             rcx
+                mov             [input_pos], rcx
 
                 pop             rdi
                 pop             rcx
                 ret
 .error:
                 mov             rax, -1
-                add             rsp, 1
                 pop             rdi
                 pop             rcx
                 ret
@@ -330,3 +426,17 @@ print_string:
 invalid_char_msg:
                 db              "Invalid character: "
 invalid_char_msg_size: equ             $ - invalid_char_msg
+
+; 10^k for k = 0..19
+pow10:
+                dq              1, 10, 100, 1000, 10000, 100000, 1000000, 10000000
+                dq              100000000, 1000000000, 10000000000, 100000000000
+                dq              1000000000000, 10000000000000, 100000000000000
+                dq              1000000000000000, 10000000000000000, 100000000000000000
+                dq              1000000000000000000, 10000000000000000000
+
+                section         .bss
+input_pos:      resq            1
+input_end:      resq            1
+input_buffer_size: equ          4096
+input_buffer:   resb            input_buffer_size